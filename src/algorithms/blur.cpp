@@ -1,69 +1,9 @@
 #include "blur.hpp"
+#include "common_filtering.hpp"
 #include "common_macro.hpp"
 
 namespace {
-enum class boundary_condition { zero, mirror, nearest };
-
-template <typename T>
-T _get_blurred(const ssimp::img::ndImage<T>& img,
-               const std::vector<std::size_t>& coords,
-               std::size_t dim_idx,
-               const std::vector<double>& right_kernel,
-               boundary_condition bound) {
-
-	std::size_t kernel_size = right_kernel.size();
-
-	std::array<double, 4> accum{};
-
-	auto coords_ = coords;
-	for (int dx = -int(kernel_size) + 1; dx < int(kernel_size); ++dx) {
-		int new_coord = int(coords[dim_idx]) + dx;
-		int max = img.dims()[dim_idx];
-
-		if (!(0 <= new_coord && new_coord < max)) {
-
-			if (bound == boundary_condition::zero)
-				continue;
-
-			if (bound == boundary_condition::mirror) {
-				if (new_coord < 0)
-					new_coord = std::abs(new_coord);
-				if (new_coord >= max)
-					new_coord = 2 * max - new_coord - 1;
-
-				// kernel does not fit
-				if (new_coord < 0)
-					return img(coords);
-			}
-			if (bound == boundary_condition::nearest)
-				new_coord = std::clamp(new_coord, 0, max - 1);
-		}
-		coords_[dim_idx] = new_coord;
-		T dx_val = img(coords_);
-		double mult = right_kernel[std::abs(dx)];
-		if constexpr (std::is_scalar_v<T>) {
-			accum[0] += dx_val * mult;
-		} else if constexpr (ssimp::mt::traits::is_complex_v<T>) {
-			accum[0] += dx_val.real() * mult;
-			accum[1] += dx_val.imag() * mult;
-		} else {
-			for (std::size_t i = 0; i < dx_val.size(); ++i)
-				accum[i] += dx_val[i] * mult;
-		}
-	}
-
-	if constexpr (std::is_scalar_v<T>)
-		return T(accum[0]);
-	else if constexpr (ssimp::mt::traits::is_complex_v<T>)
-		return T(accum[0], accum[1]);
-	else {
-		T out{};
-		for (std::size_t i = 0; i < out.size(); ++i)
-			out[i] = typename T::value_type(accum[i]);
-
-		return out;
-	}
-}
+using ssimp::algorithms::filtering::boundary_condition;
 
 inline std::vector<double> _gauss_right_kernel(double sigma) {
 	if (sigma < 10e-5)
@@ -77,25 +17,237 @@ inline std::vector<double> _gauss_right_kernel(double sigma) {
 	return out;
 }
 
-inline std::vector<double> _box_right_kernel(double size) {
-	std::size_t kernel_size = (std::size_t(size) / 2 * 2 + 1) / 2 + 1;
-	return std::vector<double>(kernel_size, 1.0 / double(2 * kernel_size - 1));
+// sigma from which the recursive filter is faster than the kernel for all
+// types, the kernel of 8-bit images is the fastest one
+constexpr double _recursive_gaussian_min_sigma = 12.0;
+
+inline std::size_t _box_radius(double size) { return std::size_t(size) / 2; }
+
+/**
+ * Kernel quantized to fixed point, the weights sum up exactly to one. Returns
+ * nothing if the quantization may change 8-bit result by more than one.
+ */
+inline std::optional<std::vector<std::int16_t>>
+_fixed_point_kernel(const std::vector<double>& kernel) {
+	namespace filtering = ssimp::algorithms::filtering;
+	constexpr double one = double(1 << filtering::fixed_point_bits);
+
+	std::vector<std::int16_t> out(kernel.size());
+	std::ranges::transform(kernel, out.begin(), [&](double weight) {
+		return std::int16_t(std::lround(weight * one));
+	});
+	std::size_t center = kernel.size() / 2;
+	out[center] += std::int16_t(std::lround(one) -
+	                            std::reduce(out.begin(), out.end(), 0L));
+
+	double error = 0.0;
+	for (std::size_t i = 0; i < kernel.size(); ++i)
+		error += std::abs(double(out[i]) / one - kernel[i]);
+	if (error * 255.0 >= 1.0)
+		return {};
+	return out;
+}
+
+template <typename T>
+void blur_dim(const ssimp::img::ndImage<T>& img,
+              ssimp::img::ndImage<T>& out,
+              std::size_t dim_idx,
+              const ssimp::algorithms::filtering::line_range& range,
+              const std::vector<double>& right_kernel,
+              boundary_condition bound,
+              std::size_t threads) {
+	namespace filtering = ssimp::algorithms::filtering;
+	using acc_t = filtering::accumulator_t<T>;
+	using sample_t = typename filtering::channels<T>::sample_t;
+
+	std::size_t radius = right_kernel.size() - 1;
+	std::vector<double> full_kernel(2 * radius + 1);
+	for (std::size_t i = 0; i < full_kernel.size(); ++i)
+		full_kernel[i] = right_kernel[i > radius ? i - radius : radius - i];
+
+	if constexpr (std::is_same_v<sample_t, std::uint8_t>) {
+		std::optional<std::vector<std::int16_t>> fixed =
+		    _fixed_point_kernel(full_kernel);
+		if (fixed) {
+			filtering::filter_lines_into<std::int16_t>(
+			    img, out, dim_idx, range, radius, bound,
+			    [&](auto line, auto filtered, auto step) {
+				    filtering::convolve_line_fixed(line, *fixed, step,
+				                                   filtered);
+			    },
+			    threads);
+			return;
+		}
+	}
+
+	std::vector<acc_t> kernel(full_kernel.begin(), full_kernel.end());
+
+	filtering::filter_lines_into<acc_t>(
+	    img, out, dim_idx, range, radius, bound,
+	    [&](auto line, auto filtered, auto step) {
+		    filtering::convolve_line<acc_t>(line, kernel, step, filtered);
+	    },
+	    threads);
 }
 
+/**
+ * Gaussian blur along **dim_idx** by recursive filter. Lines are padded as for
+ * the kernel of the same **sigma**, so all boundary conditions behave the same
+ * as with the kernel.
+ */
 template <typename T>
-ssimp::img::ndImage<T> blur_dim(const ssimp::img::ndImage<T>& img,
-                                std::size_t dim_idx,
-                                const std::vector<double>& right_kernel,
-                                boundary_condition bound) {
-	ssimp::img::ndImage<T> new_img(img.dims());
-
-	new_img.transform([&](auto _, const auto& current_coords) {
-		return _get_blurred(img, current_coords, dim_idx, right_kernel, bound);
-	});
+void recursive_blur_dim(const ssimp::img::ndImage<T>& img,
+                        ssimp::img::ndImage<T>& out,
+                        std::size_t dim_idx,
+                        const ssimp::algorithms::filtering::line_range& range,
+                        double sigma,
+                        boundary_condition bound,
+                        std::size_t threads) {
+	namespace filtering = ssimp::algorithms::filtering;
+	using acc_t = filtering::accumulator_t<T>;
 
-	return new_img;
+	std::size_t padding = std::size_t(std::ceil(3 * sigma));
+	filtering::recursive_gaussian coefs(sigma);
+
+	auto filter = [&](auto line, auto filtered, auto step) {
+		filtering::recursive_gaussian_line<acc_t>(line, coefs, padding, step,
+		                                          filtered);
+	};
+	filtering::filter_lines_into<acc_t>(img, out, dim_idx, range, padding,
+	                                    bound, filter, threads);
 }
 
+/**
+ * Box blur along **dim_idx** repeated **passes** times. Passes are applied to
+ * the line buffer directly, so intermediate results are neither rounded nor
+ * padded again; the result equals convolution with the repeated box kernel.
+ *
+ * Integer samples are summed exactly only by the first pass, later passes get
+ * fractional means and sum them as compensated doubles.
+ */
+template <typename T>
+void box_blur_dim(const ssimp::img::ndImage<T>& img,
+                  ssimp::img::ndImage<T>& out,
+                  std::size_t dim_idx,
+                  const ssimp::algorithms::filtering::line_range& range,
+                  std::size_t radius,
+                  std::size_t passes,
+                  boundary_condition bound,
+                  std::size_t threads) {
+	namespace filtering = ssimp::algorithms::filtering;
+	using acc_t = filtering::accumulator_t<T>;
+	using sample_t = typename filtering::channels<T>::sample_t;
+	using sum_t = std::conditional_t<std::is_integral_v<sample_t> &&
+	                                     sizeof(sample_t) <= 4,
+	                                 std::int64_t, acc_t>;
+	using fraction_sum_t =
+	    std::conditional_t<std::is_integral_v<sum_t>, double, sum_t>;
+
+	std::size_t window = 2 * radius + 1;
+	auto filter = [&](std::span<const acc_t> line, std::span<acc_t> filtered,
+	                  std::size_t step) {
+		auto box_pass = [&](std::size_t pass, std::span<const acc_t> in,
+		                    std::span<acc_t> out) {
+			if (pass == 0)
+				filtering::box_line<sum_t>(in, window, step, out);
+			else
+				filtering::box_line<fraction_sum_t>(in, window, step, out);
+		};
+
+		std::array<std::vector<acc_t>, 2> buffers;
+		for (std::size_t pass = 0; pass + 1 < passes; ++pass) {
+			std::vector<acc_t>& next = buffers[pass % 2];
+			next.resize(line.size() - 2 * radius * step);
+			box_pass(pass, line, std::span<acc_t>(next));
+			line = next;
+		}
+		box_pass(passes - 1, line, filtered);
+	};
+
+	filtering::filter_lines_into<acc_t>(img, out, dim_idx, range,
+	                                    radius * passes, bound, filter,
+	                                    threads);
+}
+
+// size of a slab with its halo which still stays in cache
+constexpr std::size_t _slab_bytes = std::size_t(1) << 22;
+
+/**
+ * Thickness of slabs for blur_slabs of **img**, zero if the slabs would not
+ * fit in cache or their halos would add more than a quarter of the work.
+ */
+template <typename T>
+std::size_t _slab_thickness(const ssimp::img::ndImage<T>& img,
+                            std::size_t padding) {
+	std::size_t plane = img.span().size() / img.dims().back();
+	std::size_t planes = _slab_bytes / (plane * sizeof(T));
+	if (planes <= 2 * padding || planes - 2 * padding < 8 * padding)
+		return 0;
+	return planes - 2 * padding;
+}
+
+/**
+ * Blur all dimensions of **img** slab by slab along the last dimension, so
+ * intermediate results stay in cache and only the output is written to
+ * memory. **blur_into**(in, out, dim, range, threads) blurs one dimension,
+ * **padding** is the filter radius.
+ *
+ * Each slab of **thickness** positions is taken with a halo of **padding**
+ * positions, all but the last dimension are blurred on it and the last
+ * dimension is blurred from it straight into the output; the result equals
+ * blurring the whole image dimension by dimension.
+ */
+template <typename T, typename blur_t>
+ssimp::img::ndImage<T> blur_slabs(const ssimp::img::ndImage<T>& img,
+                                  std::size_t padding,
+                                  std::size_t thickness,
+                                  blur_t&& blur_into,
+                                  std::size_t threads) {
+	using ssimp::algorithms::filtering::line_range;
+	using ssimp::img::ndImage;
+
+	std::size_t last = img.dims().size() - 1;
+	std::size_t length = img.dims()[last];
+	std::size_t plane = img.span().size() / length;
+	std::size_t slab_count = (length + thickness - 1) / thickness;
+
+	if (threads == 0)
+		threads = ssimp::parallel::default_thread_count();
+	std::size_t slab_threads = slab_count >= threads ? threads : 1;
+	std::size_t pass_threads = slab_threads > 1 ? 1 : threads;
+
+	ndImage<T> out(img.dims());
+	auto blur_slab = [&](std::size_t slab) {
+		std::size_t first = slab * thickness;
+		std::size_t count = std::min(thickness, length - first);
+		std::size_t first_in = first > padding ? first - padding : 0;
+		std::size_t end_in = std::min(length, first + count + padding);
+
+		// views into the input and output, the input view is only read
+		std::vector<std::size_t> dims(img.dims().begin(), img.dims().end());
+		dims[last] = end_in - first_in;
+		ndImage<T> slab_img(
+		    dims, nullptr,
+		    std::span(const_cast<T*>(img.span().data()) + first_in * plane,
+		              (end_in - first_in) * plane));
+		dims[last] = count;
+		ndImage<T> slab_out(
+		    dims, nullptr,
+		    std::span(out.span().data() + first * plane, count * plane));
+
+		for (std::size_t dim = 0; dim < last; ++dim) {
+			ndImage<T> blurred(slab_img.dims());
+			blur_into(slab_img, blurred, dim,
+			          line_range::whole(slab_img.dims()[dim]), pass_threads);
+			slab_img = std::move(blurred);
+		}
+		blur_into(slab_img, slab_out, last,
+		          line_range{length, first_in, first, count}, pass_threads);
+	};
+
+	ssimp::parallel::parallel_for(slab_count, blur_slab, slab_threads);
+	return out;
+}
 } // namespace
 
 namespace ssimp::algorithms {
@@ -111,14 +263,26 @@ template <typename T>
 /* static */ std::vector<img::LocalizedImage>
 Blur::apply(const std::vector<img::ndImage<T>>& imgs,
             const option_types::options_t& options) {
-	auto img_ = imgs[0];
+	const auto& img_ = imgs[0];
 
 	double intensity = std::get<double>(options.at("intensity"));
 	std::string filter = std::get<std::string>(options.at("filter"));
+	std::size_t box_passes =
+	    std::size_t(std::get<int32_t>(options.at("box_passes")));
+	std::size_t threads = std::size_t(std::get<int32_t>(options.at("threads")));
+
+	std::string method = std::get<std::string>(options.at("gaussian_method"));
+	bool box = filter == "box";
+	bool recursive =
+	    !box &&
+	    (method == "iir" ||
+	     (method == "auto" && intensity >= _recursive_gaussian_min_sigma));
+	// the recursive approximation is not valid for very small sigma
+	recursive = recursive && intensity >= 0.5;
 
-	std::vector<double> kernel =
-	    (filter == "box" ? _box_right_kernel(intensity)
-	                     : _gauss_right_kernel(intensity));
+	std::vector<double> kernel;
+	if (!box && !recursive)
+		kernel = _gauss_right_kernel(intensity);
 
 	boundary_condition bound =
 	    std::unordered_map<std::string, boundary_condition>{
@@ -127,14 +291,46 @@ Blur::apply(const std::vector<img::ndImage<T>>& imgs,
 	        {"mirror", boundary_condition::mirror}}
 	        .at(std::get<std::string>(options.at("bound_condition")));
 
+	// only the recursive filter has no fixed support
+	std::size_t padding = 0;
+	if (box)
+		padding = _box_radius(intensity) * box_passes;
+	else if (!recursive)
+		padding = kernel.size() - 1;
+
+	auto blur_into = [&](const img::ndImage<T>& img, img::ndImage<T>& out,
+	                     std::size_t dim,
+	                     const filtering::line_range& range,
+	                     std::size_t pass_threads) {
+		if (box)
+			box_blur_dim(img, out, dim, range, _box_radius(intensity),
+			             box_passes, bound, pass_threads);
+		else if (recursive)
+			recursive_blur_dim(img, out, dim, range, intensity, bound,
+			                   pass_threads);
+		else
+			blur_dim(img, out, dim, range, kernel, bound, pass_threads);
+	};
+
+	auto blur = [&](const img::ndImage<T>& img, std::size_t dim) {
+		img::ndImage<T> out(img.dims());
+		blur_into(img, out, dim,
+		          filtering::line_range::whole(img.dims()[dim]), threads);
+		return out;
+	};
+
 	if (std::get<bool>(options.at("one_dim")))
-		return {{blur_dim(img_, std::get<int32_t>(options.at("dim_idx")),
-		                  kernel, bound)}};
+		return {{blur(img_, std::get<int32_t>(options.at("dim_idx")))}};
 
-	for (std::size_t dim = 0; dim < img_.dims().size(); ++dim)
-		img_ = blur_dim(img_, dim, kernel, bound);
+	// recursive filter depends on whole lines, it can not work on slabs
+	std::size_t thickness = _slab_thickness(img_, padding);
+	if (!recursive && img_.dims().size() > 1 && thickness > 0)
+		return {{blur_slabs(img_, padding, thickness, blur_into, threads)}};
 
-	return {{img_}};
+	img::ndImage<T> out = blur(img_, 0);
+	for (std::size_t dim = 1; dim < img_.dims().size(); ++dim)
+		out = blur(out, dim);
+	return {{out}};
 }
 
 INSTANTIATE_TEMPLATE(Blur, img::GRAY_8);
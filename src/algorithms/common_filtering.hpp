@@ -0,0 +1,601 @@
+#pragma once
+#include "../application/parallel.hpp"
+#include "common.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <span>
+
+/**
+ * Line based engine for separable filters. Every line of the image along the
+ * filtered dimension is gathered into a contiguous buffer padded according to
+ * the boundary condition, filtered and scattered back. The filter itself
+ * sees only plain arrays of samples, boundaries and element types are
+ * handled here once per line.
+ */
+namespace ssimp::algorithms::filtering {
+
+enum class boundary_condition { zero, mirror, nearest };
+
+/**
+ * Image element **T** split into **count** samples of **sample_t**.
+ */
+template <typename T>
+struct channels {
+	using sample_t = T;
+	static constexpr std::size_t count = 1;
+};
+
+template <typename T>
+struct channels<std::complex<T>> {
+	using sample_t = T;
+	static constexpr std::size_t count = 2;
+};
+
+template <typename T, std::size_t N>
+struct channels<std::array<T, N>> {
+	using sample_t = T;
+	static constexpr std::size_t count = N;
+};
+
+/**
+ * Type in which lines of **T** are filtered. 8-bit and 16-bit samples are
+ * represented exactly by float, wider and floating point samples keep
+ * double.
+ */
+template <typename T>
+using accumulator_t =
+    std::conditional_t<std::is_integral_v<typename channels<T>::sample_t> &&
+                           sizeof(typename channels<T>::sample_t) <= 2,
+                       float,
+                       double>;
+
+template <typename T, typename acc_t>
+void load_element(const T& elem, acc_t* out) {
+	if constexpr (std::is_scalar_v<T>)
+		out[0] = acc_t(elem);
+	else if constexpr (mt::traits::is_complex_v<T>) {
+		out[0] = acc_t(elem.real());
+		out[1] = acc_t(elem.imag());
+	} else
+		for (std::size_t i = 0; i < elem.size(); ++i)
+			out[i] = acc_t(elem[i]);
+}
+
+/**
+ * Convert filtered sample back to **T**, integer samples are clamped to the
+ * range of **T** and truncated.
+ */
+template <typename T, typename acc_t>
+T store_sample(acc_t value) {
+	if constexpr (std::is_integral_v<T>)
+		return T(std::clamp(value, acc_t(std::numeric_limits<T>::min()),
+		                    acc_t(std::numeric_limits<T>::max())));
+	else
+		return T(value);
+}
+
+/**
+ * Convert filtered samples back to element.
+ */
+template <typename T, typename acc_t>
+T store_element(const acc_t* in) {
+	if constexpr (std::is_scalar_v<T>)
+		return store_sample<T>(in[0]);
+	else if constexpr (mt::traits::is_complex_v<T>)
+		return T(in[0], in[1]);
+	else {
+		T out{};
+		for (std::size_t i = 0; i < out.size(); ++i)
+			out[i] = store_sample<typename T::value_type>(in[i]);
+		return out;
+	}
+}
+
+constexpr std::size_t cache_line_size = 64;
+
+// padding which reads zero / can not be mirrored into the line
+constexpr std::ptrdiff_t zero_source = -1;
+constexpr std::ptrdiff_t no_source = -2;
+
+/**
+ * Source position for every position of a line of **length** elements padded
+ * by **padding** elements on both sides, padding is read from the position
+ * given by **bound**.
+ */
+inline std::vector<std::ptrdiff_t>
+padded_sources(std::size_t length,
+               std::size_t padding,
+               boundary_condition bound) {
+	std::ptrdiff_t max = std::ptrdiff_t(length);
+	std::vector<std::ptrdiff_t> out(length + 2 * padding);
+
+	for (std::size_t i = 0; i < out.size(); ++i) {
+		std::ptrdiff_t coord = std::ptrdiff_t(i) - std::ptrdiff_t(padding);
+		if (0 <= coord && coord < max) {
+			out[i] = coord;
+			continue;
+		}
+
+		switch (bound) {
+		case boundary_condition::zero:
+			out[i] = zero_source;
+			break;
+		case boundary_condition::nearest:
+			out[i] = std::clamp(coord, std::ptrdiff_t(0), max - 1);
+			break;
+		case boundary_condition::mirror:
+			if (coord < 0)
+				coord = -coord;
+			if (coord >= max)
+				coord = 2 * max - coord - 1;
+			out[i] = coord < 0 ? no_source : coord;
+			break;
+		}
+	}
+	return out;
+}
+
+/**
+ * Part of the lines of **length** positions along the filtered dimension: the
+ * input image holds positions from **first_in**, the output gets **count**
+ * positions from **first_out**.
+ */
+struct line_range {
+	std::size_t length;
+	std::size_t first_in;
+	std::size_t first_out;
+	std::size_t count;
+
+	static line_range whole(std::size_t length) {
+		return {length, 0, 0, length};
+	}
+};
+
+/**
+ * Filter lines of **img** along dimension **dim** into **out**, **range**
+ * says which part of the lines the images hold; they agree in all other
+ * dimensions. Input positions needed by the output, including padding which
+ * is mirrored into the line, must be present in **img**.
+ *
+ * Lines are processed in groups of neighbouring lines which lie next to each
+ * other in memory, so both reading and writing stay sequential for every
+ * dimension. **fun**(in, out, step) gets the group padded by **padding**
+ * positions on both sides and writes the filtered group to **out**. Every
+ * position holds **step** consecutive samples of **acc_t**, i.e. channels of
+ * the elements of all lines in the group, so samples at the same position of
+ * the buffers are filtered together independently of the others.
+ *
+ * Elements whose window of 2 * **padding** + 1 positions reaches a position
+ * which can not be mirrored into the line keep their original value.
+ *
+ * Groups are independent and are split into contiguous blocks processed by
+ * up to **threads** threads (0 means all available cores), each with its own
+ * buffers. **fun** is called concurrently.
+ */
+template <typename acc_t, typename T, typename fun_t>
+void filter_lines_into(const img::ndImage<T>& img,
+                       img::ndImage<T>& out,
+                       std::size_t dim,
+                       const line_range& range,
+                       std::size_t padding,
+                       boundary_condition bound,
+                       fun_t&& fun,
+                       std::size_t threads = 0) {
+	constexpr std::size_t channel_count = channels<T>::count;
+	// enough samples per position to fill a few vector registers and lines
+	// to read whole cache lines of the image
+	constexpr std::size_t max_group = std::max<std::size_t>(
+	    {1, 32 / channel_count, cache_line_size / sizeof(T)});
+
+	std::span<const std::size_t> dims = img.dims();
+	std::size_t length = dims[dim];
+	std::size_t stride = std::reduce(dims.begin(), dims.begin() + dim,
+	                                 std::size_t(1), std::multiplies{});
+	std::size_t outer_count = img.span().size() / (length * stride);
+	std::size_t groups_per_outer = (stride + max_group - 1) / max_group;
+	std::size_t group_count = outer_count * groups_per_outer;
+
+	std::vector<std::ptrdiff_t> all_sources =
+	    padded_sources(range.length, padding, bound);
+	std::vector<std::ptrdiff_t> sources(range.count + 2 * padding);
+	std::ranges::transform(
+	    std::span(all_sources).subspan(range.first_out, sources.size()),
+	    sources.begin(), [&](std::ptrdiff_t source) {
+		    return source < 0 ? source
+		                      : source - std::ptrdiff_t(range.first_in);
+	    });
+	std::vector<char> keep(range.count, false);
+	for (std::size_t i = 0; i < range.count; ++i)
+		keep[i] = std::ranges::any_of(
+		    std::span(sources).subspan(i, 2 * padding + 1),
+		    [](auto source) { return source == no_source; });
+
+	const T* src = img.span().data();
+	T* dst = out.span().data();
+	std::size_t max_step = std::min(stride, max_group) * channel_count;
+
+	auto filter_groups = [&](std::size_t begin, std::size_t end) {
+		std::vector<acc_t> line(sources.size() * max_step);
+		std::vector<acc_t> filtered(range.count * max_step);
+
+		for (std::size_t g = begin; g < end; ++g) {
+			std::size_t outer = g / groups_per_outer;
+			std::size_t first = g % groups_per_outer * max_group;
+			std::size_t group = std::min(max_group, stride - first);
+			std::size_t step = group * channel_count;
+			std::size_t base = outer * length * stride + first;
+			std::size_t out_base = outer * range.count * stride + first;
+
+			for (std::size_t i = 0; i < sources.size(); ++i) {
+				acc_t* samples = line.data() + i * step;
+				if (sources[i] < 0) {
+					std::fill_n(samples, step, acc_t(0));
+					continue;
+				}
+
+				const T* row = src + base + std::size_t(sources[i]) * stride;
+				for (std::size_t j = 0; j < group; ++j)
+					load_element(row[j], samples + j * channel_count);
+			}
+
+			fun(std::span<const acc_t>(line).first(sources.size() * step),
+			    std::span<acc_t>(filtered).first(range.count * step), step);
+
+			for (std::size_t i = 0; i < range.count; ++i) {
+				T* row = dst + out_base + i * stride;
+				const acc_t* samples = filtered.data() + i * step;
+				if (keep[i]) {
+					std::size_t position = range.first_out + i - range.first_in;
+					std::copy_n(src + base + position * stride, group, row);
+					continue;
+				}
+				for (std::size_t j = 0; j < group; ++j)
+					row[j] = store_element<T>(samples + j * channel_count);
+			}
+		}
+	};
+
+	if (threads == 0)
+		threads = parallel::default_thread_count();
+	// a few blocks per thread balance uneven progress of the threads
+	std::size_t block_count = std::min(group_count, threads * 4);
+	parallel::parallel_for(
+	    block_count,
+	    [&](std::size_t block) {
+		    filter_groups(block * group_count / block_count,
+		                  (block + 1) * group_count / block_count);
+	    },
+	    threads);
+}
+
+/**
+ * Filter every line of **img** along dimension **dim** with samples of the
+ * lines in **acc_t**, see filter_lines_into.
+ */
+template <typename acc_t, typename T, typename fun_t>
+img::ndImage<T> filter_lines_as(const img::ndImage<T>& img,
+                                std::size_t dim,
+                                std::size_t padding,
+                                boundary_condition bound,
+                                fun_t&& fun,
+                                std::size_t threads = 0) {
+	img::ndImage<T> out(img.dims());
+	filter_lines_into<acc_t>(img, out, dim, line_range::whole(img.dims()[dim]),
+	                         padding, bound, std::forward<fun_t>(fun), threads);
+	return out;
+}
+
+/**
+ * filter_lines with samples of the lines in **accumulator_t<T>**.
+ */
+template <typename T, typename fun_t>
+img::ndImage<T> filter_lines(const img::ndImage<T>& img,
+                             std::size_t dim,
+                             std::size_t padding,
+                             boundary_condition bound,
+                             fun_t&& fun,
+                             std::size_t threads = 0) {
+	return filter_lines_as<accumulator_t<T>>(
+	    img, dim, padding, bound, std::forward<fun_t>(fun), threads);
+}
+
+/**
+ * **out**[i] = sum of **kernel**[k] * **in**[i + k * **step**], taps summed in
+ * increasing order.
+ *
+ * Outputs are computed in blocks small enough to stay in registers over all
+ * taps; the loop over a block is a multiply-add over contiguous samples which
+ * the compiler vectorizes.
+ */
+template <typename acc_t>
+void convolve_line(std::span<const acc_t> in,
+                   std::span<const acc_t> kernel,
+                   std::size_t step,
+                   std::span<acc_t> out) {
+	constexpr std::size_t block = 64 / sizeof(acc_t);
+
+	std::size_t first = 0;
+	for (; first + block <= out.size(); first += block) {
+		std::array<acc_t, block> sums{};
+		for (std::size_t k = 0; k < kernel.size(); ++k) {
+			const acc_t* src = in.data() + first + k * step;
+			acc_t weight = kernel[k];
+			for (std::size_t i = 0; i < block; ++i)
+				sums[i] += weight * src[i];
+		}
+		std::ranges::copy(sums, out.begin() + first);
+	}
+
+	std::fill(out.begin() + first, out.end(), acc_t(0));
+	for (std::size_t k = 0; k < kernel.size(); ++k)
+		for (std::size_t i = first; i < out.size(); ++i)
+			out[i] += kernel[k] * in[i + k * step];
+}
+
+// fractional bits of fixed point kernel weights
+constexpr int fixed_point_bits = 14;
+
+/**
+ * convolve_line for 8-bit samples and weights in fixed point with
+ * **fixed_point_bits** fractional bits, the sums are truncated back to
+ * samples.
+ *
+ * Samples and weights are 16-bit and sums 32-bit, so one vector instruction
+ * processes twice as many samples as with float.
+ */
+inline void convolve_line_fixed(std::span<const std::int16_t> in,
+                                std::span<const std::int16_t> kernel,
+                                std::size_t step,
+                                std::span<std::int16_t> out) {
+	constexpr std::size_t block = 32;
+
+	std::size_t first = 0;
+	for (; first + block <= out.size(); first += block) {
+		std::array<std::int32_t, block> sums{};
+		for (std::size_t k = 0; k < kernel.size(); ++k) {
+			const std::int16_t* src = in.data() + first + k * step;
+			std::int32_t weight = kernel[k];
+			for (std::size_t i = 0; i < block; ++i)
+				sums[i] += weight * std::int32_t(src[i]);
+		}
+		for (std::size_t i = 0; i < block; ++i)
+			out[first + i] = std::int16_t(sums[i] >> fixed_point_bits);
+	}
+
+	for (std::size_t i = first; i < out.size(); ++i) {
+		std::int32_t sum = 0;
+		for (std::size_t k = 0; k < kernel.size(); ++k)
+			sum += std::int32_t(kernel[k]) * std::int32_t(in[i + k * step]);
+		out[i] = std::int16_t(sum >> fixed_point_bits);
+	}
+}
+
+/**
+ * **out**[i] = mean of **in**[i + k * **step**] for k in [0, **window**).
+ *
+ * The window slides over the line with running sums in **sum_t**, so the cost
+ * does not depend on the window size. Integer sums are exact, floating point
+ * sums are compensated (Kahan) so the error does not grow as samples enter
+ * and leave the window.
+ */
+template <typename sum_t, typename acc_t>
+void box_line(std::span<const acc_t> in,
+              std::size_t window,
+              std::size_t step,
+              std::span<acc_t> out) {
+	std::vector<sum_t> sums(step, sum_t(0));
+	std::vector<sum_t> compensations(step, sum_t(0));
+
+	auto add = [&](std::size_t s, sum_t value) {
+		if constexpr (std::is_integral_v<sum_t>)
+			sums[s] += value;
+		else {
+			sum_t y = value - compensations[s];
+			sum_t t = sums[s] + y;
+			compensations[s] = (t - sums[s]) - y;
+			sums[s] = t;
+		}
+	};
+
+	for (std::size_t k = 0; k < window; ++k)
+		for (std::size_t s = 0; s < step; ++s)
+			add(s, sum_t(in[k * step + s]));
+
+	std::size_t positions = out.size() / step;
+	for (std::size_t i = 0; i < positions; ++i) {
+		acc_t* dst = out.data() + i * step;
+		for (std::size_t s = 0; s < step; ++s)
+			dst[s] = acc_t(double(sums[s]) / double(window));
+
+		if (i + 1 == positions)
+			break;
+
+		const acc_t* entering = in.data() + (i + window) * step;
+		const acc_t* leaving = in.data() + i * step;
+		for (std::size_t s = 0; s < step; ++s)
+			add(s, sum_t(entering[s]) - sum_t(leaving[s]));
+	}
+}
+
+/**
+ * Coefficients of the recursive approximation of gaussian filter:
+ * w[n] = **b** * x[n] + **a**[0] * w[n - 1] + **a**[1] * w[n - 2] +
+ * **a**[2] * w[n - 3] forward, the same backward. Poles are those of Young,
+ * van Vliet and van Ginkel (2002), scaled so that the variance of the filter
+ * is exactly **sigma**^2.
+ *
+ * **end_state** gives the three backward outputs after the end of a line from
+ * the deviations of the last three forward outputs from the last input,
+ * assuming the input stays constant after the end (Triggs and Sdika, 2006).
+ */
+struct recursive_gaussian {
+	using matrix_t = std::array<std::array<double, 3>, 3>;
+
+	double b;
+	std::array<double, 3> a;
+	matrix_t end_state;
+
+	explicit recursive_gaussian(double sigma) {
+		using complex_t = std::complex<double>;
+		// poles of the design for sigma = 2, the third one is real
+		const std::array<complex_t, 2> base_poles{
+		    complex_t(1.41650, 1.00829), complex_t(1.86543, 0.0)};
+
+		// variance for poles base_poles^(1 / scale) and its derivative, the
+		// complex pole counts twice for its conjugate
+		auto variance = [&](double scale) {
+			double value = 0.0;
+			double derivative = 0.0;
+			for (std::size_t i = 0; i < base_poles.size(); ++i) {
+				double weight = i == 0 ? 2.0 : 1.0;
+				complex_t pole = std::pow(base_poles[i], 1.0 / scale);
+				complex_t pole_derivative =
+				    -pole * std::log(base_poles[i]) / (scale * scale);
+				value += weight * (2.0 * pole / ((pole - 1.0) * (pole - 1.0)))
+				                      .real();
+				derivative += weight * (-2.0 * (pole + 1.0) /
+				                        std::pow(pole - 1.0, 3) *
+				                        pole_derivative)
+				                           .real();
+			}
+			return std::pair{value, derivative};
+		};
+
+		double scale = sigma / 2.0;
+		for (int i = 0; i < 100; ++i) {
+			auto [value, derivative] = variance(scale);
+			double delta = (value - sigma * sigma) / derivative;
+			scale -= delta;
+			if (std::abs(delta) < 1e-12 * scale)
+				break;
+		}
+
+		complex_t pair = 1.0 / std::pow(base_poles[0], 1.0 / scale);
+		double real = (1.0 / std::pow(base_poles[1], 1.0 / scale)).real();
+		double pair_sum = 2.0 * pair.real();
+		double pair_product = std::norm(pair);
+		a = {pair_sum + real, -(pair_product + pair_sum * real),
+		     pair_product * real};
+		b = 1.0 - (a[0] + a[1] + a[2]);
+
+		// After the end the forward deviations evolve as state s' = A s.
+		// Backward output is then linear in the state, y = c^T s, and
+		// c^T (I - a0 A - a1 A^2 - a2 A^3) = b e0^T.
+		matrix_t step{{{a[0], a[1], a[2]}, {1, 0, 0}, {0, 1, 0}}};
+		std::array<matrix_t, 4> powers{identity(), step};
+		powers[2] = multiply(powers[1], step);
+		powers[3] = multiply(powers[2], step);
+
+		matrix_t system = identity();
+		for (std::size_t k = 0; k < 3; ++k)
+			for (std::size_t i = 0; i < 3; ++i)
+				for (std::size_t j = 0; j < 3; ++j)
+					system[i][j] -= a[k] * powers[k + 1][i][j];
+
+		std::array<double, 3> c = solve_transposed(system, {b, 0, 0});
+		for (std::size_t k = 0; k < 3; ++k)
+			for (std::size_t j = 0; j < 3; ++j)
+				end_state[k][j] = c[0] * powers[k + 1][0][j] +
+				                  c[1] * powers[k + 1][1][j] +
+				                  c[2] * powers[k + 1][2][j];
+	}
+
+  private:
+	static matrix_t identity() { return {{{1, 0, 0}, {0, 1, 0}, {0, 0, 1}}}; }
+
+	static matrix_t multiply(const matrix_t& lhs, const matrix_t& rhs) {
+		matrix_t out{};
+		for (std::size_t i = 0; i < 3; ++i)
+			for (std::size_t j = 0; j < 3; ++j)
+				for (std::size_t k = 0; k < 3; ++k)
+					out[i][j] += lhs[i][k] * rhs[k][j];
+		return out;
+	}
+
+	// x such that m^T x = rhs, by Cramer's rule
+	static std::array<double, 3> solve_transposed(const matrix_t& m,
+	                                              std::array<double, 3> rhs) {
+		auto det = [](const matrix_t& t) {
+			return t[0][0] * (t[1][1] * t[2][2] - t[1][2] * t[2][1]) -
+			       t[0][1] * (t[1][0] * t[2][2] - t[1][2] * t[2][0]) +
+			       t[0][2] * (t[1][0] * t[2][1] - t[1][1] * t[2][0]);
+		};
+		matrix_t transposed{};
+		for (std::size_t i = 0; i < 3; ++i)
+			for (std::size_t j = 0; j < 3; ++j)
+				transposed[i][j] = m[j][i];
+
+		double total = det(transposed);
+		std::array<double, 3> out{};
+		for (std::size_t col = 0; col < 3; ++col) {
+			matrix_t replaced = transposed;
+			for (std::size_t row = 0; row < 3; ++row)
+				replaced[row][col] = rhs[row];
+			out[col] = det(replaced) / total;
+		}
+		return out;
+	}
+};
+
+/**
+ * Gaussian filter of **in** by forward and backward recursion with
+ * **coefs**, **out** gets the positions which are at least **padding**
+ * positions away from both ends of **in**.
+ *
+ * Input before and after **in** is taken constant, which is exact for the
+ * zero and nearest boundary conditions. The cost per sample does not depend
+ * on sigma; recursion runs in double since for large sigma the poles are
+ * close to one.
+ */
+template <typename acc_t>
+void recursive_gaussian_line(std::span<const acc_t> in,
+                             const recursive_gaussian& coefs,
+                             std::size_t padding,
+                             std::size_t step,
+                             std::span<acc_t> out) {
+	std::size_t positions = in.size() / step;
+	// three steady state positions on both sides of the line
+	std::vector<double> buffer((positions + 6) * step);
+	double* line = buffer.data() + 3 * step;
+	auto [a0, a1, a2] = coefs.a;
+	double b = coefs.b;
+
+	for (std::size_t k = 1; k <= 3; ++k)
+		std::copy_n(in.data(), step, line - k * step);
+	for (std::size_t i = 0; i < positions; ++i) {
+		double* w = line + i * step;
+		const acc_t* x = in.data() + i * step;
+		for (std::size_t s = 0; s < step; ++s)
+			w[s] = b * double(x[s]) + a0 * w[s - step] + a1 * w[s - 2 * step] +
+			       a2 * w[s - 3 * step];
+	}
+
+	double* end = line + positions * step;
+	const acc_t* last = in.data() + (positions - 1) * step;
+	for (std::size_t s = 0; s < step; ++s) {
+		double u = double(last[s]);
+		std::array<double, 3> deviation{
+		    end[s - step] - u, end[s - 2 * step] - u, end[s - 3 * step] - u};
+		for (std::size_t k = 0; k < 3; ++k)
+			end[k * step + s] = u + coefs.end_state[k][0] * deviation[0] +
+			                    coefs.end_state[k][1] * deviation[1] +
+			                    coefs.end_state[k][2] * deviation[2];
+	}
+
+	for (std::size_t i = positions; i-- > 0;) {
+		double* y = line + i * step;
+		for (std::size_t s = 0; s < step; ++s)
+			y[s] = b * y[s] + a0 * y[s + step] + a1 * y[s + 2 * step] +
+			       a2 * y[s + 3 * step];
+	}
+
+	const double* result = line + padding * step;
+	for (std::size_t i = 0; i < out.size(); ++i)
+		out[i] = acc_t(result[i]);
+}
+} // namespace ssimp::algorithms::filtering
@@ -0,0 +1,623 @@
+#include "convolve.hpp"
+#include "common_filtering.hpp"
+#include "common_macro.hpp"
+#include <charconv>
+#include <fftw3.h>
+
+namespace {
+namespace filtering = ssimp::algorithms::filtering;
+using filtering::boundary_condition;
+using ssimp::exceptions::Unsupported;
+
+enum class method_t { direct, separable, fft };
+
+// cost of one FFT of n elements relative to n * log2(n) multiply-adds of the
+// direct convolution
+constexpr double _fft_cost_factor = 4.0;
+// cost of splitting channels and copying lines of the separable passes
+// relative to multiply-adds of one kernel weight
+constexpr double _separable_overhead = 12.0;
+
+/**
+ * Kernel weights, first dimension is contiguous as in images.
+ */
+struct kernel_t {
+	std::vector<std::size_t> dims;
+	std::vector<double> weights;
+};
+
+std::vector<std::string_view> split(std::string_view str, char delim) {
+	std::vector<std::string_view> out;
+	for (auto part : std::views::split(str, delim))
+		out.emplace_back(part.begin(), part.end());
+	return out;
+}
+
+double parse_weight(std::string_view str) {
+	std::size_t first = str.find_first_not_of(" \t\n");
+	std::size_t last = str.find_last_not_of(" \t\n");
+	double out = 0.0;
+	if (first != std::string_view::npos) {
+		const char* end = str.data() + last + 1;
+		auto [ptr, error] = std::from_chars(str.data() + first, end, out);
+		if (error == std::errc{} && ptr == end)
+			return out;
+	}
+	throw Unsupported(std::format("Invalid kernel weight '{}'", str));
+}
+
+/**
+ * Give **kernel** exactly **rank** dimensions, missing dimensions have size
+ * one.
+ */
+void fit_rank(kernel_t& kernel, std::size_t rank) {
+	while (kernel.dims.size() > rank) {
+		if (kernel.dims.back() != 1)
+			throw Unsupported("Kernel has more dimensions than the image");
+		kernel.dims.pop_back();
+	}
+	kernel.dims.resize(rank, 1);
+}
+
+/**
+ * Kernel written as weights separated by ',' along the first dimension, ';'
+ * along the second and '|' along the third one.
+ */
+kernel_t parse_kernel(std::string_view str, std::size_t rank) {
+	kernel_t out{{0, 0, 0}, {}};
+	auto check_size = [](std::size_t& size, std::size_t count) {
+		if (size != 0 && size != count)
+			throw Unsupported("Kernel rows differ in length");
+		size = count;
+	};
+
+	for (auto plane : split(str, '|')) {
+		++out.dims[2];
+		auto rows = split(plane, ';');
+		check_size(out.dims[1], rows.size());
+		for (auto row : rows) {
+			auto weights = split(row, ',');
+			check_size(out.dims[0], weights.size());
+			for (auto weight : weights)
+				out.weights.push_back(parse_weight(weight));
+		}
+	}
+
+	fit_rank(out, rank);
+	return out;
+}
+
+/**
+ * Kernel given by the first sample (the real part) of elements of **img**.
+ */
+template <typename T>
+kernel_t image_kernel(const ssimp::img::ndImage<T>& img, std::size_t rank) {
+	std::array<double, filtering::channels<T>::count> samples;
+	kernel_t out{img.dims(), std::vector<double>(img.span().size())};
+	std::ranges::transform(img, out.weights.begin(), [&](const T& elem) {
+		filtering::load_element(elem, samples.data());
+		return samples[0];
+	});
+
+	fit_rank(out, rank);
+	return out;
+}
+
+std::vector<std::size_t> strides_of(std::span<const std::size_t> dims) {
+	std::vector<std::size_t> out(dims.size(), 1);
+	for (std::size_t d = 1; d < dims.size(); ++d)
+		out[d] = out[d - 1] * dims[d - 1];
+	return out;
+}
+
+/**
+ * Offset of the first element of **row** in a layout with **strides**, rows
+ * enumerate all coordinates but the first one of **dims**. Coordinates are
+ * increased by **shift** if given.
+ */
+std::size_t row_offset(std::size_t row,
+                       std::span<const std::size_t> dims,
+                       std::span<const std::size_t> strides,
+                       std::span<const std::size_t> shift = {}) {
+	std::size_t out = 0;
+	for (std::size_t d = 1; d < dims.size(); ++d) {
+		std::size_t coord = row % dims[d] + (shift.empty() ? 0 : shift[d]);
+		out += coord * strides[d];
+		row /= dims[d];
+	}
+	return out;
+}
+
+/**
+ * Factors of separable **kernel**, which is their outer product, or nothing if
+ * it is not separable.
+ *
+ * Factors are lines of the kernel through its largest weight, all but the
+ * first are divided by that weight.
+ */
+std::optional<std::vector<std::vector<double>>>
+separable_factors(const kernel_t& kernel) {
+	auto pivot_it = std::ranges::max_element(
+	    kernel.weights, {}, [](double weight) { return std::abs(weight); });
+	double pivot = *pivot_it;
+	if (pivot == 0.0)
+		return {};
+
+	std::size_t pivot_idx = std::distance(kernel.weights.begin(), pivot_it);
+	std::vector<std::size_t> strides = strides_of(kernel.dims);
+	std::vector<std::vector<double>> out(kernel.dims.size());
+	for (std::size_t d = 0; d < out.size(); ++d) {
+		std::size_t line_start =
+		    pivot_idx - pivot_idx / strides[d] % kernel.dims[d] * strides[d];
+		for (std::size_t i = 0; i < kernel.dims[d]; ++i)
+			out[d].push_back(kernel.weights[line_start + i * strides[d]] /
+			                 (d == 0 ? 1.0 : pivot));
+	}
+
+	double tolerance = 1e-6 * std::abs(pivot);
+	for (std::size_t i = 0; i < kernel.weights.size(); ++i) {
+		double product = 1.0;
+		for (std::size_t d = 0; d < out.size(); ++d)
+			product *= out[d][i / strides[d] % kernel.dims[d]];
+		if (std::abs(product - kernel.weights[i]) > tolerance)
+			return {};
+	}
+	return out;
+}
+
+// padding before / after the image along a dimension of kernel of **size**
+std::size_t lead_padding(std::size_t size) { return size - 1 - size / 2; }
+std::size_t trail_padding(std::size_t size) { return size / 2; }
+
+/**
+ * Image padded by the kernel extent in every dimension according to the
+ * boundary condition. Padding which can not be mirrored into the image reads
+ * zero.
+ */
+struct padded_layout {
+	std::vector<std::size_t> dims;
+	std::vector<std::size_t> img_strides;
+	// position in the image along each dimension, negative reads zero
+	std::vector<std::vector<std::ptrdiff_t>> sources;
+
+	padded_layout(std::span<const std::size_t> img_dims,
+	              std::span<const std::size_t> kernel_dims,
+	              boundary_condition bound)
+	    : img_strides(strides_of(img_dims)) {
+		for (std::size_t d = 0; d < img_dims.size(); ++d) {
+			std::size_t lead = lead_padding(kernel_dims[d]);
+			std::size_t trail = trail_padding(kernel_dims[d]);
+			std::size_t padding = std::max(lead, trail);
+			auto all =
+			    filtering::padded_sources(img_dims[d], padding, bound);
+			auto first = all.begin() + (padding - lead);
+			sources.emplace_back(first, first + lead + img_dims[d] + trail);
+			dims.push_back(sources.back().size());
+		}
+	}
+
+	std::size_t row_count() const {
+		return std::reduce(std::next(dims.begin()), dims.end(), std::size_t(1),
+		                   std::multiplies{});
+	}
+
+	/**
+	 * Load samples of padded **row** of **img** to **out**.
+	 */
+	template <typename T, typename acc_t>
+	void load_row(const ssimp::img::ndImage<T>& img,
+	              std::size_t row,
+	              acc_t* out) const {
+		constexpr std::size_t channel_count = filtering::channels<T>::count;
+		std::ptrdiff_t offset = 0;
+		for (std::size_t d = 1; d < dims.size(); ++d) {
+			std::ptrdiff_t source = sources[d][row % dims[d]];
+			row /= dims[d];
+			if (source < 0) {
+				std::fill_n(out, dims[0] * channel_count, acc_t(0));
+				return;
+			}
+			offset += source * std::ptrdiff_t(img_strides[d]);
+		}
+
+		const T* data = img.span().data() + offset;
+		for (std::size_t i = 0; i < dims[0]; ++i, out += channel_count) {
+			if (sources[0][i] < 0)
+				std::fill_n(out, channel_count, acc_t(0));
+			else
+				filtering::load_element(data[sources[0][i]], out);
+		}
+	}
+};
+
+/**
+ * **out**[i] += sum of **kernel**[k] * **in**[i + k * **step**], see
+ * filtering::convolve_line.
+ */
+template <typename acc_t>
+void add_correlated_line(const acc_t* in,
+                         std::span<const acc_t> kernel,
+                         std::size_t step,
+                         std::span<acc_t> out) {
+	constexpr std::size_t block = 64 / sizeof(acc_t);
+
+	std::size_t first = 0;
+	for (; first + block <= out.size(); first += block) {
+		std::array<acc_t, block> sums;
+		std::copy_n(out.begin() + first, block, sums.begin());
+		for (std::size_t k = 0; k < kernel.size(); ++k) {
+			const acc_t* src = in + first + k * step;
+			acc_t weight = kernel[k];
+			for (std::size_t i = 0; i < block; ++i)
+				sums[i] += weight * src[i];
+		}
+		std::ranges::copy(sums, out.begin() + first);
+	}
+
+	for (std::size_t k = 0; k < kernel.size(); ++k)
+		for (std::size_t i = first; i < out.size(); ++i)
+			out[i] += kernel[k] * in[i + k * step];
+}
+
+/**
+ * Convolution summing all kernel weights for every element. The image is
+ * padded once, then every kernel row is added to output rows as a line
+ * convolution.
+ */
+template <typename T>
+ssimp::img::ndImage<T> convolve_direct(const ssimp::img::ndImage<T>& img,
+                                       const kernel_t& kernel,
+                                       boundary_condition bound,
+                                       std::size_t threads) {
+	using acc_t = filtering::accumulator_t<T>;
+	constexpr std::size_t channel_count = filtering::channels<T>::count;
+
+	padded_layout padded(img.dims(), kernel.dims, bound);
+	std::size_t padded_row = padded.dims[0] * channel_count;
+	std::vector<acc_t> buffer(padded_row * padded.row_count());
+	ssimp::parallel::parallel_for(
+	    padded.row_count(),
+	    [&](std::size_t row) {
+		    padded.load_row(img, row, buffer.data() + row * padded_row);
+	    },
+	    threads);
+
+	// convolution is correlation with the kernel flipped in all dimensions
+	std::vector<acc_t> flipped(kernel.weights.rbegin(), kernel.weights.rend());
+	std::vector<std::size_t> padded_strides = strides_of(padded.dims);
+	std::size_t kernel_row = kernel.dims[0];
+
+	std::vector<std::pair<std::size_t, std::span<const acc_t>>> kernel_rows;
+	for (std::size_t row = 0; row * kernel_row < flipped.size(); ++row) {
+		std::span<const acc_t> weights(flipped.data() + row * kernel_row,
+		                               kernel_row);
+		if (std::ranges::any_of(weights, [](acc_t w) { return w != 0; }))
+			kernel_rows.emplace_back(
+			    row_offset(row, kernel.dims, padded_strides), weights);
+	}
+
+	ssimp::img::ndImage<T> out(img.dims());
+	std::size_t length = img.dims()[0];
+	ssimp::parallel::parallel_for(
+	    img.span().size() / length,
+	    [&](std::size_t row) {
+		    std::vector<acc_t> sums(length * channel_count);
+		    std::size_t origin = row_offset(row, img.dims(), padded_strides);
+		    for (const auto& [offset, weights] : kernel_rows)
+			    add_correlated_line<acc_t>(
+			        buffer.data() + (origin + offset) * channel_count,
+			        weights, channel_count, sums);
+
+		    T* dest = out.span().data() + row * length;
+		    for (std::size_t i = 0; i < length; ++i)
+			    dest[i] = filtering::store_element<T>(sums.data() +
+			                                          i * channel_count);
+	    },
+	    threads);
+	return out;
+}
+
+/**
+ * Convolution by 1D **factors** of separable kernel one dimension at a time.
+ * Channels are filtered as separate images of filtered samples, so
+ * intermediate results are not clamped to the range of **T**.
+ */
+template <typename T>
+ssimp::img::ndImage<T>
+convolve_separable(const ssimp::img::ndImage<T>& img,
+                   const std::vector<std::vector<double>>& factors,
+                   boundary_condition bound,
+                   std::size_t threads) {
+	using acc_t = filtering::accumulator_t<T>;
+	constexpr std::size_t channel_count = filtering::channels<T>::count;
+
+	// factors of size one only scale the result, but kernel of one element
+	// still needs one pass
+	double scale = 1.0;
+	std::vector<std::size_t> pass_dims;
+	for (std::size_t d = 0; d < factors.size(); ++d) {
+		if (factors[d].size() > 1 ||
+		    (d + 1 == factors.size() && pass_dims.empty()))
+			pass_dims.push_back(d);
+		else
+			scale *= factors[d][0];
+	}
+
+	// flipped factors aligned in symmetric windows of the line filtering
+	std::vector<std::vector<acc_t>> taps;
+	for (std::size_t d : pass_dims) {
+		std::size_t size = factors[d].size();
+		std::size_t lead = lead_padding(size);
+		std::size_t padding = std::max(lead, trail_padding(size));
+
+		taps.emplace_back(2 * padding + 1);
+		for (std::size_t i = 0; i < size; ++i)
+			taps.back()[padding - lead + i] =
+			    acc_t(factors[d][size - 1 - i] * scale);
+		scale = 1.0;
+	}
+
+	std::vector<acc_t> samples(img.span().size() * channel_count);
+	for (std::size_t channel = 0; channel < channel_count; ++channel) {
+		ssimp::img::ndImage<acc_t> work(img.dims());
+		std::ranges::transform(img, work.begin(), [=](const T& elem) {
+			std::array<acc_t, channel_count> elem_samples;
+			filtering::load_element(elem, elem_samples.data());
+			return elem_samples[channel];
+		});
+
+		for (std::size_t pass = 0; pass < pass_dims.size(); ++pass)
+			work = filtering::filter_lines_as<acc_t>(
+			    work, pass_dims[pass], taps[pass].size() / 2, bound,
+			    [&](auto line, auto filtered, auto step) {
+				    filtering::convolve_line<acc_t>(line, taps[pass], step,
+				                                    filtered);
+			    },
+			    threads);
+
+		for (std::size_t i = 0; i < work.span().size(); ++i)
+			samples[i * channel_count + channel] = work.span()[i];
+	}
+
+	ssimp::img::ndImage<T> out(img.dims());
+	for (std::size_t i = 0; i < out.span().size(); ++i)
+		out.span()[i] =
+		    filtering::store_element<T>(samples.data() + i * channel_count);
+	return out;
+}
+
+/**
+ * Smallest length of at least **length** without prime factors above 7,
+ * FFTW is fastest for such lengths.
+ */
+std::size_t fft_length(std::size_t length) {
+	for (;; ++length) {
+		std::size_t rest = length;
+		for (std::size_t prime : {2, 3, 5, 7})
+			while (rest % prime == 0)
+				rest /= prime;
+		if (rest == 1)
+			return length;
+	}
+}
+
+std::vector<std::size_t> fft_dims(const padded_layout& padded) {
+	std::vector<std::size_t> out(padded.dims.size());
+	std::ranges::transform(padded.dims, out.begin(), fft_length);
+	return out;
+}
+
+/**
+ * Convolution as multiplication of spectra. The padded image is transformed
+ * as a whole, so its circular convolution does not wrap into the output.
+ */
+template <typename T>
+ssimp::img::ndImage<T> convolve_fft(const ssimp::img::ndImage<T>& img,
+                                    const kernel_t& kernel,
+                                    boundary_condition bound) {
+	using complex_t = std::complex<double>;
+	using sample_t = typename filtering::channels<T>::sample_t;
+	constexpr std::size_t channel_count = filtering::channels<T>::count;
+
+	// integer results differing only by rounding errors of the transforms
+	// would be truncated to the previous integer
+	auto snap = [](double x) {
+		double nearest = std::round(x);
+		return std::abs(x - nearest) < 1e-6 ? nearest : x;
+	};
+
+	padded_layout padded(img.dims(), kernel.dims, bound);
+	std::vector<std::size_t> dims = fft_dims(padded);
+	std::vector<std::size_t> strides = strides_of(dims);
+	std::size_t volume = strides.back() * dims.back();
+
+	// FFTW expects the last dimension to be contiguous
+	std::vector<int> n(dims.rbegin(), dims.rend());
+	auto transform = [&](std::vector<complex_t>& data, int direction) {
+		auto* ptr = reinterpret_cast<fftw_complex*>(data.data());
+		fftw_plan plan = fftw_plan_dft(int(n.size()), n.data(), ptr, ptr,
+		                               direction, FFTW_ESTIMATE);
+		fftw_execute(plan);
+		fftw_destroy_plan(plan);
+	};
+
+	std::vector<complex_t> spectrum(volume);
+	std::size_t kernel_row = kernel.dims[0];
+	for (std::size_t row = 0; row * kernel_row < kernel.weights.size(); ++row)
+		std::copy_n(kernel.weights.begin() + row * kernel_row, kernel_row,
+		            spectrum.begin() + row_offset(row, kernel.dims, strides));
+	transform(spectrum, FFTW_FORWARD);
+	for (complex_t& x : spectrum)
+		x /= double(volume);
+
+	// the first output element is the last one affected by the padding
+	std::vector<std::size_t> shift(kernel.dims.size());
+	std::ranges::transform(kernel.dims, shift.begin(),
+	                       [](std::size_t size) { return size - 1; });
+
+	std::size_t length = img.dims()[0];
+	std::size_t out_rows = img.span().size() / length;
+	std::vector<double> samples(img.span().size() * channel_count);
+	std::vector<double> row_samples(padded.dims[0] * channel_count);
+	std::vector<complex_t> data(volume);
+
+	// the kernel is real, so real and imaginary parts are convolved
+	// independently and every transform convolves two channels
+	for (std::size_t first = 0; first < channel_count; first += 2) {
+		bool pair = first + 1 < channel_count;
+		std::ranges::fill(data, complex_t(0.0));
+		for (std::size_t row = 0; row < padded.row_count(); ++row) {
+			padded.load_row(img, row, row_samples.data());
+			complex_t* dest =
+			    data.data() + row_offset(row, padded.dims, strides);
+			for (std::size_t i = 0; i < padded.dims[0]; ++i) {
+				const double* src = row_samples.data() + i * channel_count;
+				dest[i] = {src[first], pair ? src[first + 1] : 0.0};
+			}
+		}
+
+		transform(data, FFTW_FORWARD);
+		std::ranges::transform(data, spectrum, data.begin(), std::multiplies{});
+		transform(data, FFTW_BACKWARD);
+		if constexpr (std::is_integral_v<sample_t>)
+			for (complex_t& x : data)
+				x = {snap(x.real()), snap(x.imag())};
+
+		for (std::size_t row = 0; row < out_rows; ++row) {
+			const complex_t* src = data.data() + shift[0] +
+			                       row_offset(row, img.dims(), strides, shift);
+			double* dest = samples.data() + row * length * channel_count;
+			for (std::size_t i = 0; i < length; ++i) {
+				dest[i * channel_count + first] = src[i].real();
+				if (pair)
+					dest[i * channel_count + first + 1] = src[i].imag();
+			}
+		}
+	}
+
+	ssimp::img::ndImage<T> out(img.dims());
+	for (std::size_t i = 0; i < out.span().size(); ++i)
+		out.span()[i] =
+		    filtering::store_element<T>(samples.data() + i * channel_count);
+	return out;
+}
+
+/**
+ * Cheapest method for convolution of image of **dims** by **kernel**, the
+ * separable method is considered only if the kernel is **separable**.
+ */
+method_t cheapest_method(std::span<const std::size_t> dims,
+                         std::size_t channel_count,
+                         const kernel_t& kernel,
+                         const padded_layout& padded,
+                         bool separable,
+                         std::size_t threads) {
+	double elements = double(std::reduce(dims.begin(), dims.end(),
+	                                     std::size_t(1), std::multiplies{}));
+
+	double direct = elements * double(kernel.weights.size());
+	double passes = 0.0;
+	for (std::size_t size : kernel.dims)
+		passes += size > 1 ? double(size) : 0.0;
+	double separable_cost = elements * (passes + _separable_overhead);
+
+	std::vector<std::size_t> fft = fft_dims(padded);
+	double volume = double(
+	    std::reduce(fft.begin(), fft.end(), std::size_t(1), std::multiplies{}));
+	// kernel transform and forward and backward transform for channel pairs
+	double transforms = 1.0 + 2.0 * double((channel_count + 1) / 2);
+	// FFT runs in one thread, the other methods in all of them
+	double fft_cost = _fft_cost_factor * transforms * volume *
+	                  std::log2(volume) * double(threads) /
+	                  double(channel_count);
+
+	if (separable && separable_cost <= std::min(direct, fft_cost))
+		return method_t::separable;
+	return direct <= fft_cost ? method_t::direct : method_t::fft;
+}
+} // namespace
+
+namespace ssimp::algorithms {
+bool Convolve::image_count_supported(std::size_t count) {
+	return count == 1 || count == 2;
+}
+bool Convolve::image_dims_supported(std::span<const std::size_t> dims) {
+	return dims.size() > 0 &&
+	       std::ranges::all_of(dims, [](auto x) { return x > 0; });
+}
+bool Convolve::same_dims_required() { return false; }
+
+template <typename T>
+    requires mt::traits::is_any_of_tuple_v<T, Convolve::supported_types>
+/* static */ std::vector<img::LocalizedImage>
+Convolve::apply(const std::vector<img::ndImage<T>>& imgs,
+                const option_types::options_t& options) {
+	const auto& img_ = imgs[0];
+	std::size_t rank = img_.dims().size();
+
+	kernel_t kernel =
+	    imgs.size() > 1
+	        ? image_kernel(imgs[1], rank)
+	        : parse_kernel(std::get<std::string>(options.at("kernel")), rank);
+
+	if (std::get<bool>(options.at("normalize"))) {
+		double sum = std::reduce(kernel.weights.begin(), kernel.weights.end());
+		if (std::abs(sum) < 1e-12)
+			throw Unsupported("Kernel weights sum up to zero");
+		for (double& weight : kernel.weights)
+			weight /= sum;
+	}
+
+	boundary_condition bound =
+	    std::unordered_map<std::string, boundary_condition>{
+	        {"zero", boundary_condition::zero},
+	        {"nearest", boundary_condition::nearest},
+	        {"mirror", boundary_condition::mirror}}
+	        .at(std::get<std::string>(options.at("bound_condition")));
+
+	std::size_t threads = std::size_t(std::get<int32_t>(options.at("threads")));
+	if (threads == 0)
+		threads = parallel::default_thread_count();
+
+	padded_layout padded(img_.dims(), kernel.dims, bound);
+	std::optional<std::vector<std::vector<double>>> factors =
+	    separable_factors(kernel);
+	// lines padded symmetrically could read positions which can not be
+	// mirrored, which the other methods read as zero
+	for (std::size_t d = 0; factors && d < rank; ++d)
+		if (bound == boundary_condition::mirror &&
+		    kernel.dims[d] / 2 >= img_.dims()[d])
+			factors.reset();
+
+	std::string method_name = std::get<std::string>(options.at("method"));
+	method_t method =
+	    method_name == "auto"
+	        ? cheapest_method(img_.dims(), filtering::channels<T>::count,
+	                          kernel, padded, factors.has_value(), threads)
+	    : method_name == "fft"                 ? method_t::fft
+	    : method_name == "separable" && factors ? method_t::separable
+	                                            : method_t::direct;
+
+	switch (method) {
+	case method_t::separable:
+		return {{convolve_separable(img_, *factors, bound, threads)}};
+	case method_t::fft:
+		return {{convolve_fft(img_, kernel, bound)}};
+	default:
+		return {{convolve_direct(img_, kernel, bound, threads)}};
+	}
+}
+
+INSTANTIATE_TEMPLATE(Convolve, img::GRAY_8);
+INSTANTIATE_TEMPLATE(Convolve, img::GRAY_16);
+INSTANTIATE_TEMPLATE(Convolve, img::GRAY_32);
+INSTANTIATE_TEMPLATE(Convolve, img::GRAY_64);
+INSTANTIATE_TEMPLATE(Convolve, img::GRAYA_8);
+INSTANTIATE_TEMPLATE(Convolve, img::RGB_8);
+INSTANTIATE_TEMPLATE(Convolve, img::RGBA_8);
+INSTANTIATE_TEMPLATE(Convolve, img::FLOAT);
+INSTANTIATE_TEMPLATE(Convolve, img::DOUBLE);
+INSTANTIATE_TEMPLATE(Convolve, img::COMPLEX_F);
+INSTANTIATE_TEMPLATE(Convolve, img::COMPLEX_D);
+
+} // namespace ssimp::algorithms
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "common.hpp"
+
+namespace ssimp::algorithms {
+/**
+ * Convolution with arbitrary kernel, given either inline by the options or as
+ * the second image. The kernel element at index size / 2 of every dimension
+ * is aligned with the output element.
+ *
+ * Separable kernels are applied one dimension at a time, large kernels by
+ * FFT.
+ */
+class Convolve {
+  public:
+	using supported_types = std::tuple<img::GRAY_8,
+	                                   img::GRAY_16,
+	                                   img::GRAY_32,
+	                                   img::GRAY_64,
+	                                   img::GRAYA_8,
+	                                   img::RGB_8,
+	                                   img::RGBA_8,
+	                                   img::FLOAT,
+	                                   img::DOUBLE,
+	                                   img::COMPLEX_F,
+	                                   img::COMPLEX_D>;
+	constexpr static const char* name = "convolve";
+
+	static bool image_count_supported(std::size_t count);
+	static bool image_dims_supported(std::span<const std::size_t> dims);
+	static bool same_dims_required();
+
+	template <typename T>
+	    requires mt::traits::is_any_of_tuple_v<T, Convolve::supported_types>
+	static std::vector<img::LocalizedImage>
+	apply(const std::vector<img::ndImage<T>>& imgs,
+	      const option_types::options_t& options);
+};
+
+} // namespace ssimp::algorithms
@@ -0,0 +1,393 @@
+#include "median.hpp"
+#include "common_filtering.hpp"
+#include "common_macro.hpp"
+
+namespace {
+namespace filtering = ssimp::algorithms::filtering;
+using filtering::boundary_condition;
+
+using comparator_t = std::pair<std::uint8_t, std::uint8_t>;
+
+// networks of N. Devillard leaving median of 9 / 25 values in the middle
+constexpr std::array<comparator_t, 19> _median_network_9{{
+    {1, 2}, {4, 5}, {7, 8}, {0, 1}, {3, 4}, {6, 7}, {1, 2}, {4, 5}, {7, 8},
+    {0, 3}, {5, 8}, {4, 7}, {3, 6}, {1, 4}, {2, 5}, {4, 7}, {4, 2}, {6, 4},
+    {4, 2}}};
+
+constexpr std::array<comparator_t, 99> _median_network_25{{
+    {0, 1},   {3, 4},   {2, 4},   {2, 3},   {6, 7},   {5, 7},   {5, 6},
+    {9, 10},  {8, 10},  {8, 9},   {12, 13}, {11, 13}, {11, 12}, {15, 16},
+    {14, 16}, {14, 15}, {18, 19}, {17, 19}, {17, 18}, {21, 22}, {20, 22},
+    {20, 21}, {23, 24}, {2, 5},   {3, 6},   {0, 6},   {0, 3},   {4, 7},
+    {1, 7},   {1, 4},   {11, 14}, {8, 14},  {8, 11},  {12, 15}, {9, 15},
+    {9, 12},  {13, 16}, {10, 16}, {10, 13}, {20, 23}, {17, 23}, {17, 20},
+    {21, 24}, {18, 24}, {18, 21}, {19, 22}, {8, 17},  {9, 18},  {0, 18},
+    {0, 9},   {10, 19}, {1, 19},  {1, 10},  {11, 20}, {2, 20},  {2, 11},
+    {12, 21}, {3, 21},  {3, 12},  {13, 22}, {4, 22},  {4, 13},  {14, 23},
+    {5, 23},  {5, 14},  {15, 24}, {6, 24},  {6, 15},  {7, 16},  {7, 19},
+    {13, 21}, {15, 23}, {7, 13},  {7, 15},  {1, 9},   {3, 11},  {5, 17},
+    {11, 17}, {9, 17},  {4, 10},  {6, 12},  {7, 14},  {4, 6},   {4, 7},
+    {12, 14}, {10, 14}, {6, 7},   {10, 12}, {6, 10},  {6, 17},  {12, 17},
+    {7, 17},  {7, 10},  {12, 18}, {7, 12},  {10, 18}, {12, 20}, {10, 20},
+    {10, 12}}};
+
+// radius from which 8-bit images use histograms instead of sorting networks
+constexpr std::size_t _histogram_min_radius = 3;
+
+template <typename T>
+using sample_t = typename filtering::channels<T>::sample_t;
+
+template <typename T>
+sample_t<T>& sample_at(T& elem, std::size_t channel) {
+	if constexpr (std::is_scalar_v<T>)
+		return elem;
+	else
+		return elem[channel];
+}
+
+template <typename T>
+sample_t<T> sample_at(const T& elem, std::size_t channel) {
+	if constexpr (std::is_scalar_v<T>)
+		return elem;
+	else
+		return elem[channel];
+}
+
+/**
+ * 2D image padded by **radius** on all sides according to the boundary
+ * condition. Padding which can not be mirrored into the image reads zero.
+ */
+template <typename T>
+struct padded_plane {
+	const ssimp::img::ndImage<T>& img;
+	std::size_t radius;
+	std::vector<std::ptrdiff_t> xs;
+	std::vector<std::ptrdiff_t> ys;
+
+	padded_plane(const ssimp::img::ndImage<T>& img,
+	             std::size_t radius,
+	             boundary_condition bound)
+	    : img(img), radius(radius),
+	      xs(filtering::padded_sources(img.dims()[0], radius, bound)),
+	      ys(filtering::padded_sources(img.dims()[1], radius, bound)) {}
+
+	std::size_t width() const { return xs.size(); }
+	std::size_t window() const { return 2 * radius + 1; }
+
+	/**
+	 * Load **channel** of padded row **y** to **out**.
+	 */
+	void load_row(std::size_t y, std::size_t channel, sample_t<T>* out) const {
+		if (ys[y] < 0) {
+			std::fill_n(out, xs.size(), sample_t<T>(0));
+			return;
+		}
+
+		const T* row = img.span().data() + ys[y] * img.dims()[0];
+		for (std::size_t x = 0; x < xs.size(); ++x)
+			out[x] =
+			    xs[x] < 0 ? sample_t<T>(0) : sample_at(row[xs[x]], channel);
+	}
+};
+
+/**
+ * Padded rows of the window of output row, consecutive output rows reuse
+ * all rows but one.
+ */
+template <typename T>
+class window_rows {
+  public:
+	window_rows(const padded_plane<T>& plane, std::size_t channel)
+	    : _plane(plane), _channel(channel),
+	      _samples(plane.window() * plane.width()) {}
+
+	/**
+	 * Load window rows of output row **y**.
+	 */
+	void load(std::size_t y) {
+		std::size_t window = _plane.window();
+		std::size_t from = _loaded && y == _first + 1 ? y + window - 1 : y;
+		for (std::size_t row = from; row < y + window; ++row)
+			_plane.load_row(row, _channel, _slot(row));
+		_first = y;
+		_loaded = true;
+	}
+
+	/**
+	 * **i**-th row of the window.
+	 */
+	const sample_t<T>* row(std::size_t i) { return _slot(_first + i); }
+
+  private:
+	sample_t<T>* _slot(std::size_t row) {
+		return _samples.data() + row % _plane.window() * _plane.width();
+	}
+
+	const padded_plane<T>& _plane;
+	std::size_t _channel;
+	std::vector<sample_t<T>> _samples;
+	std::size_t _first = 0;
+	bool _loaded = false;
+};
+
+/**
+ * Median of output rows [**first**, **last**) by sorting **network** of
+ * window samples. The network runs over blocks of pixels at once, so every
+ * comparator is a vectorized min and max.
+ */
+template <typename T, std::size_t N>
+void median_rows_network(const padded_plane<T>& plane,
+                         const std::array<comparator_t, N>& network,
+                         std::size_t first,
+                         std::size_t last,
+                         ssimp::img::ndImage<T>& out) {
+	constexpr std::size_t block = 64;
+	std::size_t window = plane.window();
+	std::size_t length = out.dims()[0];
+
+	std::vector<std::array<sample_t<T>, block>> values(window * window);
+	for (std::size_t channel = 0; channel < filtering::channels<T>::count;
+	     ++channel) {
+		window_rows<T> rows(plane, channel);
+		for (std::size_t y = first; y < last; ++y) {
+			rows.load(y);
+			T* dest = out.span().data() + y * length;
+
+			for (std::size_t x = 0; x < length; x += block) {
+				std::size_t count = std::min(block, length - x);
+				for (std::size_t dy = 0; dy < window; ++dy)
+					for (std::size_t dx = 0; dx < window; ++dx)
+						std::copy_n(rows.row(dy) + x + dx, count,
+						            values[dy * window + dx].begin());
+
+				for (auto [lo, hi] : network) {
+					sample_t<T>* lo_values = values[lo].data();
+					sample_t<T>* hi_values = values[hi].data();
+					for (std::size_t i = 0; i < block; ++i) {
+						sample_t<T> a = lo_values[i];
+						sample_t<T> b = hi_values[i];
+						// forms which GCC turns into vector min and max
+						if constexpr (std::is_floating_point_v<sample_t<T>>) {
+							lo_values[i] = std::min(a, b);
+							hi_values[i] = std::max(a, b);
+						} else {
+							lo_values[i] = a < b ? a : b;
+							hi_values[i] = a < b ? b : a;
+						}
+					}
+				}
+
+				const auto& median = values[values.size() / 2];
+				for (std::size_t i = 0; i < count; ++i)
+					sample_at(dest[x + i], channel) = median[i];
+			}
+		}
+	}
+}
+
+/**
+ * Median of output rows [**first**, **last**) of 8-bit samples by the
+ * algorithm of Perreault and Hebert, whose cost does not depend on the radius.
+ *
+ * Every padded column keeps histogram of its window rows, so moving down
+ * updates it by two samples. Window histogram adds one column and removes
+ * another while moving right. Its 16 coarse bins select the fine bins holding
+ * the median, the fine bins are brought up to date only when searched.
+ */
+template <typename T>
+void median_rows_histogram(const padded_plane<T>& plane,
+                           std::size_t first,
+                           std::size_t last,
+                           ssimp::img::ndImage<T>& out) {
+	constexpr std::size_t bins = 256;
+	constexpr std::size_t coarse_bins = 16;
+	constexpr std::size_t fine_bins = bins / coarse_bins;
+	constexpr std::size_t stale = std::numeric_limits<std::size_t>::max();
+
+	std::size_t window = plane.window();
+	std::size_t width = plane.width();
+	std::size_t length = out.dims()[0];
+	std::size_t rank = window * window / 2;
+
+	// columns of windows allowed by the options fit 16-bit counts
+	std::vector<std::uint16_t> column_fine(width * bins);
+	std::vector<std::uint16_t> column_coarse(width * coarse_bins);
+	std::vector<std::uint8_t> row_samples(width);
+	std::array<std::uint32_t, bins> fine;
+	std::array<std::uint32_t, coarse_bins> coarse;
+	// column at which the fine bins of each coarse bin are up to date
+	std::array<std::size_t, coarse_bins> fine_x;
+
+	for (std::size_t channel = 0; channel < filtering::channels<T>::count;
+	     ++channel) {
+		auto update_columns = [&](std::size_t row, int delta) {
+			plane.load_row(row, channel, row_samples.data());
+			for (std::size_t x = 0; x < width; ++x) {
+				std::uint8_t value = row_samples[x];
+				column_fine[x * bins + value] += delta;
+				column_coarse[x * coarse_bins + value / fine_bins] += delta;
+			}
+		};
+		auto update_coarse = [&](std::size_t x, int delta) {
+			for (std::size_t bin = 0; bin < coarse_bins; ++bin)
+				coarse[bin] += delta * column_coarse[x * coarse_bins + bin];
+		};
+		auto update_fine = [&](std::size_t x, std::size_t bin, int delta) {
+			const std::uint16_t* column =
+			    column_fine.data() + x * bins + bin * fine_bins;
+			for (std::size_t i = 0; i < fine_bins; ++i)
+				fine[bin * fine_bins + i] += delta * column[i];
+		};
+
+		std::ranges::fill(column_fine, 0);
+		std::ranges::fill(column_coarse, 0);
+		for (std::size_t row = first; row + 1 < first + window; ++row)
+			update_columns(row, 1);
+
+		for (std::size_t y = first; y < last; ++y) {
+			update_columns(y + window - 1, 1);
+			T* dest = out.span().data() + y * length;
+
+			coarse.fill(0);
+			fine_x.fill(stale);
+			for (std::size_t x = 0; x < window; ++x)
+				update_coarse(x, 1);
+
+			for (std::size_t x = 0; x < length; ++x) {
+				if (x > 0) {
+					update_coarse(x + window - 1, 1);
+					update_coarse(x - 1, -1);
+				}
+
+				std::size_t count = 0;
+				std::size_t bin = 0;
+				while (count + coarse[bin] <= rank)
+					count += coarse[bin++];
+
+				// sliding costs two columns per step, rebuilding one per
+				// window column
+				if (fine_x[bin] == stale || 2 * (x - fine_x[bin]) > window) {
+					std::fill_n(fine.begin() + bin * fine_bins, fine_bins, 0);
+					for (std::size_t col = x; col < x + window; ++col)
+						update_fine(col, bin, 1);
+				} else {
+					for (std::size_t col = fine_x[bin] + 1; col <= x; ++col) {
+						update_fine(col + window - 1, bin, 1);
+						update_fine(col - 1, bin, -1);
+					}
+				}
+				fine_x[bin] = x;
+
+				std::size_t value = bin * fine_bins;
+				while (count + fine[value] <= rank)
+					count += fine[value++];
+				sample_at(dest[x], channel) = std::uint8_t(value);
+			}
+
+			update_columns(y, -1);
+		}
+	}
+}
+
+/**
+ * Median of output rows [**first**, **last**) by partial sorting of every
+ * window.
+ */
+template <typename T>
+void median_rows_select(const padded_plane<T>& plane,
+                        std::size_t first,
+                        std::size_t last,
+                        ssimp::img::ndImage<T>& out) {
+	std::size_t window = plane.window();
+	std::size_t length = out.dims()[0];
+
+	std::vector<sample_t<T>> values(window * window);
+	auto median = values.begin() + values.size() / 2;
+	for (std::size_t channel = 0; channel < filtering::channels<T>::count;
+	     ++channel) {
+		window_rows<T> rows(plane, channel);
+		for (std::size_t y = first; y < last; ++y) {
+			rows.load(y);
+			T* dest = out.span().data() + y * length;
+
+			for (std::size_t x = 0; x < length; ++x) {
+				for (std::size_t dy = 0; dy < window; ++dy)
+					std::copy_n(rows.row(dy) + x, window,
+					            values.begin() + dy * window);
+				std::nth_element(values.begin(), median, values.end());
+				sample_at(dest[x], channel) = *median;
+			}
+		}
+	}
+}
+} // namespace
+
+namespace ssimp::algorithms {
+bool Median::image_count_supported(std::size_t count) { return count == 1; }
+bool Median::image_dims_supported(std::span<const std::size_t> dims) {
+	return dims.size() == 2 &&
+	       std::ranges::all_of(dims, [](auto x) { return x > 0; });
+}
+bool Median::same_dims_required() { return true; }
+
+template <typename T>
+    requires mt::traits::is_any_of_tuple_v<T, Median::supported_types>
+/* static */ std::vector<img::LocalizedImage>
+Median::apply(const std::vector<img::ndImage<T>>& imgs,
+              const option_types::options_t& options) {
+	const auto& img_ = imgs[0];
+
+	std::size_t radius = std::size_t(std::get<int32_t>(options.at("radius")));
+	std::size_t threads = std::size_t(std::get<int32_t>(options.at("threads")));
+	if (threads == 0)
+		threads = parallel::default_thread_count();
+
+	boundary_condition bound =
+	    std::unordered_map<std::string, boundary_condition>{
+	        {"zero", boundary_condition::zero},
+	        {"nearest", boundary_condition::nearest},
+	        {"mirror", boundary_condition::mirror}}
+	        .at(std::get<std::string>(options.at("bound_condition")));
+
+	padded_plane<T> plane(img_, radius, bound);
+	img::ndImage<T> out(img_.dims());
+
+	auto median_rows = [&](std::size_t first, std::size_t last) {
+		if constexpr (std::is_same_v<sample_t<T>, std::uint8_t>)
+			if (radius >= _histogram_min_radius)
+				return median_rows_histogram(plane, first, last, out);
+
+		if (radius == 1)
+			median_rows_network(plane, _median_network_9, first, last, out);
+		else if (radius == 2)
+			median_rows_network(plane, _median_network_25, first, last, out);
+		else
+			median_rows_select(plane, first, last, out);
+	};
+
+	// strips load their first window rows again, a few strips per thread
+	// balance uneven progress of the threads
+	std::size_t height = img_.dims()[1];
+	std::size_t strip_count = std::min(height, threads * 4);
+	parallel::parallel_for(
+	    strip_count,
+	    [&](std::size_t strip) {
+		    median_rows(strip * height / strip_count,
+		                (strip + 1) * height / strip_count);
+	    },
+	    threads);
+
+	return {{out}};
+}
+
+INSTANTIATE_TEMPLATE(Median, img::GRAY_8);
+INSTANTIATE_TEMPLATE(Median, img::GRAY_16);
+INSTANTIATE_TEMPLATE(Median, img::GRAY_32);
+INSTANTIATE_TEMPLATE(Median, img::GRAY_64);
+INSTANTIATE_TEMPLATE(Median, img::GRAYA_8);
+INSTANTIATE_TEMPLATE(Median, img::RGB_8);
+INSTANTIATE_TEMPLATE(Median, img::RGBA_8);
+INSTANTIATE_TEMPLATE(Median, img::FLOAT);
+INSTANTIATE_TEMPLATE(Median, img::DOUBLE);
+
+} // namespace ssimp::algorithms
@@ -0,0 +1,115 @@
+#include "transform.hpp"
+#include "common_macro.hpp"
+#include <cstddef>
+#include <format>
+
+namespace {
+/**
+ * Walk of the source image producing transformed image. Pixel (x, y) of the
+ * output is taken from flat index origin + x * step_x + y * step_y of the
+ * source.
+ */
+struct Walk {
+	std::size_t width;
+	std::size_t height;
+	std::ptrdiff_t origin;
+	std::ptrdiff_t step_x;
+	std::ptrdiff_t step_y;
+};
+
+Walk get_walk(const std::string& operation, std::size_t w, std::size_t h) {
+	std::ptrdiff_t sw = w;
+	std::ptrdiff_t sh = h;
+
+	if (operation == "none")
+		return {w, h, 0, 1, sw};
+	if (operation == "rotate_90")
+		return {h, w, (sh - 1) * sw, -sw, 1};
+	if (operation == "rotate_180")
+		return {w, h, sh * sw - 1, -1, -sw};
+	if (operation == "rotate_270")
+		return {h, w, sw - 1, sw, -1};
+	if (operation == "flip_horizontal")
+		return {w, h, sw - 1, -1, sw};
+	if (operation == "flip_vertical")
+		return {w, h, (sh - 1) * sw, 1, -sw};
+	if (operation == "transpose")
+		return {h, w, 0, sw, 1};
+	if (operation == "transverse")
+		return {h, w, sh * sw - 1, -sw, -1};
+
+	throw ssimp::exceptions::Unsupported(
+	    std::format("Unknown operation '{}'", operation));
+}
+} // namespace
+
+namespace ssimp::algorithms {
+/* static */ bool Transform::image_count_supported(std::size_t count) {
+	return count == 1;
+}
+
+/* static */ bool
+Transform::image_dims_supported(std::span<const std::size_t> dims) {
+	return dims.size() == 2 && dims[0] > 0 && dims[1] > 0;
+}
+
+/* static */ bool Transform::same_dims_required() { return false; }
+
+template <typename T>
+    requires mt::traits::is_any_of_tuple_v<T, Transform::supported_types>
+/* static */ std::vector<img::LocalizedImage>
+Transform::apply(const std::vector<img::ndImage<T>>& imgs,
+                 const option_types::options_t& options) {
+	const auto& img_ = imgs[0];
+
+	Walk walk =
+	    get_walk(std::get<std::string>(options.at("operation")),
+	             img_.dims()[0], img_.dims()[1]);
+
+	if (std::get<bool>(options.at("crop"))) {
+		std::size_t x = std::get<int32_t>(options.at("crop_x"));
+		std::size_t y = std::get<int32_t>(options.at("crop_y"));
+		std::size_t width = std::get<int32_t>(options.at("crop_width"));
+		std::size_t height = std::get<int32_t>(options.at("crop_height"));
+
+		if (x >= walk.width || y >= walk.height)
+			throw exceptions::Unsupported(
+			    "Crop region is outside of the image");
+
+		width = width == 0 ? walk.width - x : width;
+		height = height == 0 ? walk.height - y : height;
+		if (x + width > walk.width || y + height > walk.height)
+			throw exceptions::Unsupported(
+			    "Crop region is outside of the image");
+
+		walk.origin += std::ptrdiff_t(x) * walk.step_x +
+		               std::ptrdiff_t(y) * walk.step_y;
+		walk.width = width;
+		walk.height = height;
+	}
+
+	img::ndImage<T> out(int(walk.width), int(walk.height));
+	const T* src = img_.data();
+	T* dst = out.data();
+
+	for (std::size_t y = 0; y < walk.height; ++y) {
+		const T* src_row = src + walk.origin + std::ptrdiff_t(y) * walk.step_y;
+		for (std::size_t x = 0; x < walk.width; ++x)
+			*dst++ = src_row[std::ptrdiff_t(x) * walk.step_x];
+	}
+
+	return {{out}};
+}
+
+INSTANTIATE_TEMPLATE(Transform, img::GRAY_8);
+INSTANTIATE_TEMPLATE(Transform, img::GRAYA_8);
+INSTANTIATE_TEMPLATE(Transform, img::GRAY_16);
+INSTANTIATE_TEMPLATE(Transform, img::GRAY_32);
+INSTANTIATE_TEMPLATE(Transform, img::GRAY_64);
+INSTANTIATE_TEMPLATE(Transform, img::RGB_8);
+INSTANTIATE_TEMPLATE(Transform, img::RGBA_8);
+INSTANTIATE_TEMPLATE(Transform, img::FLOAT);
+INSTANTIATE_TEMPLATE(Transform, img::DOUBLE);
+INSTANTIATE_TEMPLATE(Transform, img::COMPLEX_F);
+INSTANTIATE_TEMPLATE(Transform, img::COMPLEX_D);
+} // namespace ssimp::algorithms
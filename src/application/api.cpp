@@ -109,6 +109,35 @@ API::load_one(const fs::path& path,
 	return images[0];
 }
 
+std::vector<img::LocalizedImage>
+API::load_image_from_memory(std::span<const std::byte> bytes,
+                            const std::string& format /* = "" */,
+                            const option_types::options_t& options
+                            /* = {} */) const {
+	if (!format.empty())
+		_check_format_validity(format);
+
+	std::vector<std::string> formats;
+	if (!format.empty())
+		formats.push_back(format);
+	else
+		for (const auto& name : _format_manager->registered())
+			formats.push_back(name);
+
+	for (const auto& f : formats) {
+		if (!_options_manager->is_valid(f + "_loading", options))
+			continue;
+
+		auto out = _format_manager->load_image_from_memory(
+		    bytes, f,
+		    _options_manager->finalize_options(f + "_loading", options));
+		if (out)
+			return *out;
+	}
+
+	throw exceptions::Unsupported("Memory buffer contains unsupported image");
+}
+
 std::vector<std::vector<img::LocalizedImage>>
 API::load_directory(const fs::path& dir,
                     bool recurse /* = false */,
@@ -168,6 +197,70 @@ void API::save_one(const img::ndImageBase& img,
 	save_image({img}, path, format, options);
 }
 
+std::vector<std::byte>
+API::encode_image(const std::vector<img::ndImageBase>& img,
+                  const std::string& format,
+                  const option_types::options_t& options /* = {} */) const {
+	_check_format_validity(format);
+
+	if (!img.empty() &&
+	    !_format_manager->is_type_supported(format, img[0].type()))
+		throw exceptions::Unsupported(
+		    std::format("Format '{}' does not support '{}'", format,
+		                to_string(img[0].type())));
+
+	if (!_format_manager->is_count_supported(format, img.size()))
+		throw exceptions::Unsupported(std::format(
+		    "Format '{}' does not support '{}' images", format, img.size()));
+
+	if (std::ranges::any_of(img, [&](auto x) {
+		    return !_format_manager->is_dims_supported(format, x.dims());
+	    }))
+		throw exceptions::Unsupported(std::format(
+		    "Format '{}' does not support image of given dimensionality",
+		    format));
+
+	if (!_options_manager->is_valid(format + "_saving", options))
+		throw exceptions::Unsupported(std::format(
+		    "Given options are not supported for format '{}'", format));
+
+	return _format_manager->encode_image(
+	    img, format,
+	    _options_manager->finalize_options(format + "_saving", options));
+}
+
+bool API::transform_lossless(
+    const fs::path& input,
+    const fs::path& output,
+    const std::string& format,
+    const std::vector<option_types::options_t>& transforms) const {
+	_check_format_validity(format);
+	if (!_format_manager->is_lossless_transform_supported(format))
+		return false;
+
+	std::string options_id = algorithms::Transform::name + "_algo"s;
+	std::vector<option_types::options_t> finalized;
+	for (const auto& options : transforms) {
+		if (!_options_manager->is_valid(options_id, options))
+			throw exceptions::Unsupported(std::format(
+			    "Given options are not supported for algorithm '{}'",
+			    algorithms::Transform::name));
+		finalized.push_back(
+		    _options_manager->finalize_options(options_id, options));
+	}
+
+	try {
+		if (get_properties(input).format != format)
+			return false;
+	} catch (const exceptions::Unsupported&) {
+		return false;
+	}
+
+	return _format_manager->transform_lossless(
+	    input, _extension_manager->with_correct_extension(format, output),
+	    format, finalized);
+}
+
 ImageProperties
 API::get_properties(const fs::path& path,
                     const option_types::options_t& options /* = {} */) const {
@@ -2,9 +2,11 @@
 
 #include "nd_image.hpp"
 #include "utils.hpp"
+#include <cstddef>
 #include <filesystem>
 #include <memory>
 #include <set>
+#include <span>
 #include <vector>
 
 namespace ssimp {
@@ -52,6 +54,18 @@ class API {
 	         const std::string& format = "",
 	         const option_types::options_t& options = {}) const;
 
+	/**
+	 * Decode image(s) held in memory as **bytes** (e.g. received over
+	 * network).
+	 *
+	 * If **format** is specified, only that format is used. Otherwise try
+	 * every supported format.
+	 */
+	std::vector<img::LocalizedImage>
+	load_image_from_memory(std::span<const std::byte> bytes,
+	                       const std::string& format = "",
+	                       const option_types::options_t& options = {}) const;
+
 	/**
 	 * Load all files in directory as images. For search in subdirectories,
 	 * set **recurse** to *true*.
@@ -84,6 +98,29 @@ class API {
 	              const std::string& format = "",
 	              const option_types::options_t& options = {}) const;
 
+	/**
+	 * Encode **img** using **format** and return the content of the file it
+	 * would be saved as.
+	 */
+	std::vector<std::byte>
+	encode_image(const std::vector<img::ndImageBase>& img,
+	             const std::string& format,
+	             const option_types::options_t& options = {}) const;
+
+	/**
+	 * Apply 'transform' algorithm steps with **transforms** options to image
+	 * at **input** and save it to **output** in the same **format** without
+	 * decoding it (e.g. JPEG rotation in DCT domain).
+	 *
+	 * Return false and write nothing if the image at **input** is not in
+	 * **format** or the format can not perform the steps losslessly.
+	 */
+	bool transform_lossless(
+	    const std::filesystem::path& input,
+	    const std::filesystem::path& output,
+	    const std::string& format,
+	    const std::vector<option_types::options_t>& transforms) const;
+
 	/**
 	 * Get properties of image located at **path**.
 	 */
@@ -2,6 +2,7 @@
 #include <algorithm>
 #include <boost/json.hpp>
 #include <boost/program_options.hpp>
+#include <cmath>
 #include <filesystem>
 #include <format>
 #include <fstream>
@@ -419,12 +420,33 @@ ssimp::option_types::options_t load_saving_options() {
 	return {};
 }
 
+/**
+ * Whether **count** images are saved together into one file of **format**.
+ * Formats with 'yuv_planes' option (JPEG) store several images only as planes.
+ */
+bool _save_together(std::size_t count,
+                    const std::string& format,
+                    const ssimp::option_types::options_t& options,
+                    const ssimp::API& api) {
+	if (!api.is_count_supported_format(format, count))
+		return false;
+
+	if (count == 1 ||
+	    std::ranges::none_of(
+	        api.saving_options_configuration(format),
+	        [](const auto& opt) { return opt.id() == "yuv_planes"; }))
+		return true;
+
+	return options.contains("yuv_planes") &&
+	       options.at("yuv_planes") == ssimp::option_types::value_t(true);
+}
+
 void save_image(const std::vector<ssimp::img::LocalizedImage>& images,
                 const fs::path& path,
                 const std::string& format,
                 const ssimp::option_types::options_t& options,
                 const ssimp::API& api) {
-	if (api.is_count_supported_format(format, images.size()))
+	if (_save_together(images.size(), format, options, api))
 		api.save_image(api.delocalize(images), path, format, options);
 	else if (api.is_count_supported_format(format, 1)) {
 		fs::create_directories(path);
@@ -478,12 +500,107 @@ std::vector<ssimp::img::LocalizedImage> apply_algorithms(
 	return out;
 }
 
+/**
+ * If the pipeline starts with a downscaling 'resize', let the format decode
+ * the image directly at reduced size (when it supports 'downscale' loading
+ * option). The resize is then turned into exact resolution, so the result is
+ * the same as if the full image was loaded. Loading a region or YUV planes
+ * is left as it is.
+ *
+ * Returns format to load the image with, or empty string if no hint is used.
+ */
+std::string _hint_decode_size(
+    const ssimp::API& api,
+    ssimp::option_types::options_t& loading_options,
+    std::unordered_map<std::string, ssimp::option_types::options_t>&
+        algo_options) {
+	// the size of a region or planes differs from the size of the image
+	auto enabled = [&](const std::string& id) {
+		return loading_options.contains(id) &&
+		       loading_options.at(id) == ssimp::option_types::value_t(true);
+	};
+	if (_arg_algorithms.empty() ||
+	    _remove_algo_suffix(_arg_algorithms[0]) != "resize" ||
+	    loading_options.contains("downscale") || enabled("region") ||
+	    enabled("yuv_planes"))
+		return "";
+
+	auto& resize_options = algo_options[_arg_algorithms[0]];
+	if (!resize_options.contains("scale_factor") ||
+	    !std::holds_alternative<double>(resize_options.at("scale_factor")))
+		return "";
+
+	double factor = std::get<double>(resize_options.at("scale_factor"));
+	if (factor > 0.5 || (resize_options.contains("exact_res") &&
+	                     resize_options.at("exact_res") !=
+	                         ssimp::option_types::value_t("auto")))
+		return "";
+
+	ssimp::ImageProperties props;
+	try {
+		props = api.get_properties(_arg_input_path);
+	} catch (const ssimp::exceptions::Unsupported&) {
+		return "";
+	}
+
+	if (std::ranges::none_of(
+	        api.loading_options_configuration(props.format),
+	        [](const auto& opt) { return opt.id() == "downscale"; }))
+		return "";
+
+	std::string exact_res;
+	for (std::size_t dim : props.dims) {
+		if (!exact_res.empty())
+			exact_res += ',';
+		exact_res += std::to_string(
+		    std::max<std::size_t>(1, std::llround(dim * factor)));
+	}
+
+	loading_options["downscale"] = factor;
+	resize_options.erase("scale_factor");
+	resize_options["exact_res"] = exact_res;
+	print_debug("decoding at reduced size, resize changed to exact res '{}'",
+	            exact_res);
+
+	return props.format;
+}
+
 void throw_if_exists(const fs::path& path) {
 	if (!_arg_allow_override && fs::exists(path))
 		throw std::runtime_error(
 		    std::format("{} already exists, use --allow_override to force",
 		                ssimp::to_string(_arg_output_path)));
 }
+
+/**
+ * If the pipeline consists only of 'transform' steps and no loading or saving
+ * options are given, try to apply it without decoding the image (e.g. JPEG
+ * rotation in DCT domain). Return true if the output was written.
+ */
+bool try_lossless_transform(
+    const ssimp::API& api,
+    const ssimp::option_types::options_t& loading_options,
+    const ssimp::option_types::options_t& saving_options,
+    const std::unordered_map<std::string, ssimp::option_types::options_t>&
+        algo_options) {
+	if (_arg_algorithms.empty() || !loading_options.empty() ||
+	    !saving_options.empty() ||
+	    std::ranges::any_of(_arg_algorithms, [](const auto& algo) {
+		    return _remove_algo_suffix(algo) != "transform";
+	    }))
+		return false;
+
+	std::vector<ssimp::option_types::options_t> transforms;
+	for (const auto& algo : _arg_algorithms)
+		transforms.push_back(algo_options.contains(algo)
+		                         ? algo_options.at(algo)
+		                         : ssimp::option_types::options_t{});
+
+	fs::create_directories(_arg_output_path.parent_path());
+	throw_if_exists(_arg_output_path);
+	return api.transform_lossless(_arg_input_path, _arg_output_path,
+	                              _arg_format, transforms);
+}
 } // namespace
 
 int main(int argc, const char** argv) {
@@ -516,8 +633,18 @@ int main(int argc, const char** argv) {
 				return 0;
 			}
 
-			auto images =
-			    api.load_image(_arg_input_path, "", "", loading_options);
+			if (try_lossless_transform(api, loading_options, saving_options,
+			                           algo_options)) {
+				print_debug("{} transformed without decoding",
+				            ssimp::to_string(_arg_input_path));
+				print_debug("exiting ... (location 4)");
+				return 0;
+			}
+
+			std::string load_format =
+			    _hint_decode_size(api, loading_options, algo_options);
+			auto images = api.load_image(_arg_input_path, "", load_format,
+			                             loading_options);
 			print_debug("{} loaded, got {} images",
 			            ssimp::to_string(_arg_input_path), images.size());
 			images = apply_algorithms(images, algo_options, api);
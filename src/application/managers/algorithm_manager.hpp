@@ -2,10 +2,13 @@
 
 #include "../../algorithms/blur.hpp"
 #include "../../algorithms/change_type.hpp"
+#include "../../algorithms/convolve.hpp"
 #include "../../algorithms/fft.hpp"
+#include "../../algorithms/median.hpp"
 #include "../../algorithms/split_channels.hpp"
 #include "../../algorithms/unary_math.hpp"
 #include "../../algorithms/resize.hpp"
+#include "../../algorithms/transform.hpp"
 #include "../nd_image.hpp"
 #include "_algo_format_base.hpp"
 #include <functional>
@@ -23,7 +26,10 @@ class AlgorithmManager : public details::_AlgoFormatBase {
 	                                          algorithms::Blur,
 	                                          algorithms::FFT,
 	                                          algorithms::UnaryMath,
-						  algorithms::Resize>;
+						  algorithms::Resize,
+	                                          algorithms::Transform,
+	                                          algorithms::Convolve,
+	                                          algorithms::Median>;
 
   public:
 	/**
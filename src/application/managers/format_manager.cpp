@@ -9,7 +9,8 @@ namespace fs = std::filesystem;
 namespace {
 template <typename format_t, typename supported_types>
 struct img_save_dispatcher {
-	static void save(const auto& imgs, const auto& path, const auto& options) {
+	template <typename ret_t>
+	static ret_t dispatch(const auto& imgs, const auto& fun) {
 		throw ssimp::exceptions::Unsupported(
 		    std::format("Format '{}' does not support '{}'", format_t::name,
 		                ssimp::to_string(imgs[0].type())));
@@ -18,7 +19,11 @@ struct img_save_dispatcher {
 
 template <typename format_t, typename type_t, typename... rest_t>
 struct img_save_dispatcher<format_t, std::tuple<type_t, rest_t...>> {
-	static void save(const auto& imgs, const auto& path, const auto& options) {
+	/**
+	 * Convert **imgs** to the typed images and pass them to **fun**.
+	 */
+	template <typename ret_t>
+	static ret_t dispatch(const auto& imgs, const auto& fun) {
 		ssimp::img::elem_type img_type = ssimp::img::type_to_enum<type_t>;
 		if (imgs.size() == 0 || img_type == imgs[0].type()) {
 			if (std::ranges::any_of(imgs, [=](const auto& img) {
@@ -33,11 +38,10 @@ struct img_save_dispatcher<format_t, std::tuple<type_t, rest_t...>> {
 			for (const auto& img : imgs)
 				typed.push_back(img.template as_typed<type_t>());
 
-			format_t::save_image(typed, path, options);
-			return;
+			return fun(typed);
 		}
-		img_save_dispatcher<format_t, std::tuple<rest_t...>>::save(imgs, path,
-		                                                           options);
+		return img_save_dispatcher<format_t, std::tuple<rest_t...>>::
+		    template dispatch<ret_t>(imgs, fun);
 	}
 };
 
@@ -56,15 +60,26 @@ struct fill_supported_types<std::tuple<type_t, rest_t...>> {
 
 template <typename T>
 struct format_registerer {
-	static void
-	register_format(auto&, auto&, auto&, auto&, auto&, auto&, auto&) {}
+	static void register_format(auto&,
+	                            auto&,
+	                            auto&,
+	                            auto&,
+	                            auto&,
+	                            auto&,
+	                            auto&,
+	                            auto&,
+	                            auto&,
+	                            auto&) {}
 };
 
 template <typename first_t, typename... types_t>
 struct format_registerer<std::tuple<first_t, types_t...>> {
 	static void register_format(auto& loaders,
+	                            auto& memory_loaders,
 	                            auto& savers,
+	                            auto& encoders,
 	                            auto& info_getters,
+	                            auto& transformers,
 	                            auto& count_verifs,
 	                            auto& dims_verifs,
 	                            auto& same_dims,
@@ -78,11 +93,26 @@ struct format_registerer<std::tuple<first_t, types_t...>> {
 			return first_t::load_image(path, options);
 		};
 
+		memory_loaders[first_t::name] = [](const auto& bytes,
+		                                   const auto& options) {
+			return first_t::load_image_from_memory(bytes, options);
+		};
+
 		savers[first_t::name] = [](const auto& imgs, const auto& path,
 		                           const auto& options) {
-			img_save_dispatcher<
-			    first_t, typename first_t::supported_types>::save(imgs, path,
-			                                                      options);
+			img_save_dispatcher<first_t, typename first_t::supported_types>::
+			    template dispatch<void>(imgs, [&](const auto& typed) {
+				    first_t::save_image(typed, path, options);
+			    });
+		};
+
+		encoders[first_t::name] = [](const auto& imgs, const auto& options) {
+			return img_save_dispatcher<first_t,
+			                           typename first_t::supported_types>::
+			    template dispatch<std::vector<std::byte>>(
+			        imgs, [&](const auto& typed) {
+				        return first_t::encode_image(typed, options);
+			        });
 		};
 
 		info_getters[first_t::name] = [](const auto& path,
@@ -90,6 +120,14 @@ struct format_registerer<std::tuple<first_t, types_t...>> {
 			return first_t::get_information(path, options);
 		};
 
+		// optional capability
+		if constexpr (requires { &first_t::transform_lossless; })
+			transformers[first_t::name] = [](const auto& input,
+			                                 const auto& output,
+			                                 const auto& transforms) {
+				return first_t::transform_lossless(input, output, transforms);
+			};
+
 		count_verifs[first_t::name] = [](auto count) {
 			return first_t::image_count_supported(count);
 		};
@@ -104,7 +142,8 @@ struct format_registerer<std::tuple<first_t, types_t...>> {
 		    supported_types[first_t::name]);
 
 		format_registerer<std::tuple<types_t...>>::register_format(
-		    loaders, savers, info_getters, count_verifs, dims_verifs, same_dims,
+		    loaders, memory_loaders, savers, encoders, info_getters,
+		    transformers, count_verifs, dims_verifs, same_dims,
 		    supported_types);
 	}
 };
@@ -114,7 +153,8 @@ struct format_registerer<std::tuple<first_t, types_t...>> {
 namespace ssimp {
 FormatManager::FormatManager() {
 	format_registerer<_registered_formats>::register_format(
-	    _image_loaders, _image_savers, _information_getters, _count_verifiers,
+	    _image_loaders, _memory_image_loaders, _image_savers, _image_encoders,
+	    _information_getters, _lossless_transformers, _count_verifiers,
 	    _dims_verifiers, _same_dims_required, _supported_types);
 }
 
@@ -125,6 +165,14 @@ FormatManager::load_image(const fs::path& path,
 	return _image_loaders.at(format)(path, options);
 }
 
+std::optional<std::vector<img::LocalizedImage>>
+FormatManager::load_image_from_memory(
+    std::span<const std::byte> bytes,
+    const std::string& format,
+    const option_types::options_t& options) const {
+	return _memory_image_loaders.at(format)(bytes, options);
+}
+
 void FormatManager::save_image(const fs::path& path,
                                const std::vector<img::ndImageBase>& image,
                                const std::string& format,
@@ -132,6 +180,26 @@ void FormatManager::save_image(const fs::path& path,
 	_image_savers.at(format)(image, path, options);
 }
 
+std::vector<std::byte>
+FormatManager::encode_image(const std::vector<img::ndImageBase>& image,
+                            const std::string& format,
+                            const option_types::options_t& options) const {
+	return _image_encoders.at(format)(image, options);
+}
+
+bool FormatManager::is_lossless_transform_supported(
+    const std::string& format) const {
+	return _lossless_transformers.contains(format);
+}
+
+bool FormatManager::transform_lossless(
+    const fs::path& input,
+    const fs::path& output,
+    const std::string& format,
+    const std::vector<option_types::options_t>& transforms) const {
+	return _lossless_transformers.at(format)(input, output, transforms);
+}
+
 std::optional<ssimp::ImageProperties> FormatManager::get_image_information(
     const std::filesystem::path& path,
     const std::string& format,
@@ -1,15 +1,21 @@
 #pragma once
 
+#include "../../formats/chunked.hpp"
 #include "../../formats/jpeg.hpp"
+#include "../../formats/npy.hpp"
 #include "../../formats/png.hpp"
+#include "../../formats/pnm.hpp"
+#include "../../formats/qoi.hpp"
 #include "../../formats/testing_sample.hpp"
 #include "../nd_image.hpp"
 #include "../utils.hpp"
 #include "_algo_format_base.hpp"
 #include "options_manager.hpp"
 #include <filesystem>
+#include <cstddef>
 #include <functional>
 #include <optional>
+#include <span>
 #include <tuple>
 #include <unordered_map>
 #include <vector>
@@ -18,7 +24,9 @@ namespace ssimp {
 class FormatManager : public details::_AlgoFormatBase {
   private:
 	using _registered_formats =
-	    std::tuple</* formats::TestingSample, */ formats::JPEG, formats::PNG>;
+	    std::tuple</* formats::TestingSample, */ formats::JPEG, formats::PNG,
+	               formats::NPY, formats::Chunked, formats::QOI,
+	               formats::PNM>;
 
   public:
 	/**
@@ -34,6 +42,15 @@ class FormatManager : public details::_AlgoFormatBase {
 	           const std::string& format,
 	           const option_types::options_t& options) const;
 
+	/**
+	 * Decode image held in memory as **bytes** using provided input
+	 * **options**.
+	 */
+	std::optional<std::vector<img::LocalizedImage>>
+	load_image_from_memory(std::span<const std::byte> bytes,
+	                       const std::string& format,
+	                       const option_types::options_t& options) const;
+
 	/**
 	 * Save **image** to **path** using **format** with **options**.
 	 */
@@ -42,6 +59,32 @@ class FormatManager : public details::_AlgoFormatBase {
 	                const std::string& format,
 	                const option_types::options_t& options) const;
 
+	/**
+	 * Encode **image** using **format** with **options** and return the
+	 * resulting file content.
+	 */
+	std::vector<std::byte>
+	encode_image(const std::vector<img::ndImageBase>& image,
+	             const std::string& format,
+	             const option_types::options_t& options) const;
+
+	/**
+	 * Return true if **format** can apply 'transform' algorithm without
+	 * decoding the image.
+	 */
+	bool is_lossless_transform_supported(const std::string& format) const;
+
+	/**
+	 * Apply 'transform' steps with **transforms** options to image at
+	 * **input** and save it to **output** without decoding it. Return false
+	 * if it can not be done losslessly.
+	 */
+	bool transform_lossless(
+	    const std::filesystem::path& input,
+	    const std::filesystem::path& output,
+	    const std::string& format,
+	    const std::vector<option_types::options_t>& transforms) const;
+
 	/**
 	 * Get image information
 	 */
@@ -55,16 +98,31 @@ class FormatManager : public details::_AlgoFormatBase {
 	    std::function<std::optional<std::vector<img::LocalizedImage>>(
 	        const std::filesystem::path&, const _options_t&)>;
 
+	using _memory_loading_function_t =
+	    std::function<std::optional<std::vector<img::LocalizedImage>>(
+	        std::span<const std::byte>, const _options_t&)>;
+
 	using _saving_function_t =
 	    std::function<void(const std::vector<img::ndImageBase>&,
 	                       const std::filesystem::path&,
 	                       const _options_t&)>;
 
+	using _encoding_function_t = std::function<std::vector<std::byte>(
+	    const std::vector<img::ndImageBase>&, const _options_t&)>;
+
 	using _info_function_t = std::function<std::optional<ImageProperties>(
 	    const std::filesystem::path&, const option_types::options_t&)>;
 
+	using _transform_function_t =
+	    std::function<bool(const std::filesystem::path&,
+	                       const std::filesystem::path&,
+	                       const std::vector<_options_t>&)>;
+
 	_funmap_t<_loading_function_t> _image_loaders;
+	_funmap_t<_memory_loading_function_t> _memory_image_loaders;
 	_funmap_t<_saving_function_t> _image_savers;
+	_funmap_t<_encoding_function_t> _image_encoders;
 	_funmap_t<_info_function_t> _information_getters;
+	_funmap_t<_transform_function_t> _lossless_transformers;
 };
 } // namespace ssimp
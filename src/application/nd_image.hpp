@@ -132,11 +132,21 @@ class ndImageBase {
 	ndImageBase(std::span<const std::size_t> dims,
 	            std::size_t elem_size,
 	            elem_type type)
-	    : _data(std::make_shared<std::vector<std::byte>>(
-	          std::reduce(
-	              dims.begin(), dims.end(), std::size_t(1), std::multiplies{}) *
-	          elem_size)),
-	      _dims(dims.begin(), dims.end()), _type(type) {}
+	    : _size(std::reduce(dims.begin(), dims.end(), std::size_t(1),
+	                        std::multiplies{}) *
+	            elem_size),
+	      _data(_allocate(_size)), _dims(dims.begin(), dims.end()),
+	      _type(type) {}
+
+	/**
+	 * Image over **size** bytes of already existing **data**.
+	 */
+	ndImageBase(std::span<const std::size_t> dims,
+	            elem_type type,
+	            std::shared_ptr<std::byte[]> data,
+	            std::size_t size)
+	    : _size(size), _data(std::move(data)), _dims(dims.begin(), dims.end()),
+	      _type(type) {}
 
   public:
 	ndImageBase(const ndImageBase&) = default;
@@ -175,8 +185,9 @@ class ndImageBase {
 		ndImageBase cpy;
 		cpy._type = _type;
 		cpy._dims = _dims;
-		cpy._data = std::make_shared<std::vector<std::byte>>(_data->begin(),
-		                                                     _data->end());
+		cpy._size = _size;
+		cpy._data = _allocate(_size);
+		std::copy_n(_data.get(), _size, cpy._data.get());
 		return cpy;
 	}
 
@@ -191,7 +202,16 @@ class ndImageBase {
 	}
 
   protected:
-	std::shared_ptr<std::vector<std::byte>> _data;
+	/**
+	 * Allocate zero initialized storage for **size** bytes.
+	 */
+	static std::shared_ptr<std::byte[]> _allocate(std::size_t size) {
+		auto storage = std::make_shared<std::vector<std::byte>>(size);
+		return {storage, storage->data()};
+	}
+
+	std::size_t _size = 0;
+	std::shared_ptr<std::byte[]> _data;
 	std::vector<std::size_t> _dims;
 	elem_type _type;
 };
@@ -390,13 +410,28 @@ class ndImage : public ndImageBase {
 	explicit ndImage(std::span<const std::size_t> sp)
 	    : ndImageBase(sp, sizeof(T), type_to_enum<T>) {}
 
+	/**
+	 * Construct image over **data** owned by **owner** (for example a memory
+	 * mapped file) without copying it. The owner is kept alive as long as any
+	 * image shares the data.
+	 */
+	ndImage(std::span<const std::size_t> sp,
+	        std::shared_ptr<void> owner,
+	        std::span<T> data)
+	    : ndImageBase(sp,
+	                  type_to_enum<T>,
+	                  {std::move(owner), std::as_writable_bytes(data).data()},
+	                  data.size_bytes()) {
+		assert(data.size() == std::reduce(sp.begin(), sp.end(), std::size_t(1),
+		                                  std::multiplies{}));
+	}
+
 	std::span<T> span() {
-		return {reinterpret_cast<T*>(_data->data()), _data->size() / sizeof(T)};
+		return {reinterpret_cast<T*>(_data.get()), _size / sizeof(T)};
 	}
 
 	std::span<const T> span() const {
-		return {reinterpret_cast<const T*>(_data->data()),
-		        _data->size() / sizeof(T)};
+		return {reinterpret_cast<const T*>(_data.get()), _size / sizeof(T)};
 	}
 
 	/**
@@ -404,7 +439,7 @@ class ndImage : public ndImageBase {
 	 */
 	ndImage copy() const {
 		ndImage cpy(_dims);
-		std::ranges::copy(*_data, cpy._data->begin());
+		std::copy_n(_data.get(), _size, cpy._data.get());
 
 		return cpy;
 	}
@@ -0,0 +1,177 @@
+#pragma once
+
+/**
+ * This file provides simple data parallelism used by formats and algorithms.
+ *
+ * All code is placed inside **parallel** namespace.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ssimp::parallel {
+/**
+ * Number of threads used when the caller does not specify it.
+ */
+inline std::size_t default_thread_count() {
+	return std::max(1u, std::thread::hardware_concurrency());
+}
+
+namespace details {
+/**
+ * Threads shared by all calls of **parallel_for**, so the threads are not
+ * spawned again for every call. Created on first use, threads are added when
+ * a call asks for more of them.
+ */
+class WorkerPool {
+  public:
+	static WorkerPool& instance() {
+		static WorkerPool pool;
+		return pool;
+	}
+
+	/**
+	 * Make sure at least **count** threads are running.
+	 */
+	void reserve(std::size_t count) {
+		std::lock_guard lock(_mutex);
+		while (_workers.size() < count)
+			_workers.emplace_back([this]() { _run(); });
+	}
+
+	/**
+	 * Run **task** on one of the threads.
+	 */
+	void submit(std::function<void()> task) {
+		{
+			std::lock_guard lock(_mutex);
+			_tasks.push_back(std::move(task));
+		}
+		_ready.notify_one();
+	}
+
+	~WorkerPool() {
+		{
+			std::lock_guard lock(_mutex);
+			_stopping = true;
+		}
+		_ready.notify_all();
+		// workers are joined before the rest of the members is destroyed
+		_workers.clear();
+	}
+
+  private:
+	WorkerPool() = default;
+
+	void _run() {
+		while (true) {
+			std::function<void()> task;
+			{
+				std::unique_lock lock(_mutex);
+				_ready.wait(lock,
+				            [this]() { return _stopping || !_tasks.empty(); });
+				if (_tasks.empty())
+					return;
+				task = std::move(_tasks.front());
+				_tasks.pop_front();
+			}
+			task();
+		}
+	}
+
+	std::mutex _mutex;
+	std::condition_variable _ready;
+	std::deque<std::function<void()>> _tasks;
+	bool _stopping = false;
+	std::vector<std::jthread> _workers;
+};
+} // namespace details
+
+/**
+ * Call **fun**(i) for every i in [0, **count**) using at most **threads**
+ * threads (0 means **default_thread_count()**). The calling thread takes part
+ * in the work, the others are taken from a pool shared by all calls. With one
+ * thread (or one task) the pool is not used at all.
+ *
+ * Tasks are taken dynamically, so they do not need to be of equal size. If
+ * any call throws, remaining tasks are skipped and the first exception is
+ * rethrown after all threads finished. Calls may be nested, the calling
+ * thread finishes the work itself when the pool is busy.
+ */
+template <typename fun_t>
+void parallel_for(std::size_t count, fun_t&& fun, std::size_t threads = 0) {
+	if (threads == 0)
+		threads = default_thread_count();
+	threads = std::min(threads, count);
+
+	if (threads <= 1) {
+		for (std::size_t i = 0; i < count; ++i)
+			fun(i);
+		return;
+	}
+
+	// shared with helpers which may start only after this call returned
+	struct state_t {
+		std::atomic<std::size_t> next = 0;
+		std::exception_ptr error;
+		std::mutex mutex;
+		std::condition_variable idle;
+		std::size_t active = 0;
+		bool closed = false;
+	};
+	auto state = std::make_shared<state_t>();
+
+	auto worker = [&]() {
+		for (std::size_t i = state->next++; i < count; i = state->next++) {
+			try {
+				fun(i);
+			} catch (...) {
+				std::lock_guard lock(state->mutex);
+				if (!state->error)
+					state->error = std::current_exception();
+				state->next = count;
+			}
+		}
+	};
+
+	// helpers use **worker** only while the call waits for them
+	auto helper = [state, &worker]() {
+		{
+			std::lock_guard lock(state->mutex);
+			if (state->closed)
+				return;
+			++state->active;
+		}
+		worker();
+		{
+			std::lock_guard lock(state->mutex);
+			--state->active;
+		}
+		state->idle.notify_all();
+	};
+
+	details::WorkerPool& pool = details::WorkerPool::instance();
+	pool.reserve(threads - 1);
+	for (std::size_t i = 0; i + 1 < threads; ++i)
+		pool.submit(helper);
+	worker();
+
+	{
+		std::unique_lock lock(state->mutex);
+		state->closed = true;
+		state->idle.wait(lock, [&]() { return state->active == 0; });
+	}
+
+	if (state->error)
+		std::rethrow_exception(state->error);
+}
+} // namespace ssimp::parallel
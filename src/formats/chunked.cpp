@@ -0,0 +1,530 @@
+#include "chunked.hpp"
+#include "../application/parallel.hpp"
+#include "common_macro.hpp"
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <boost/json.hpp>
+#include <cstring>
+#include <numeric>
+#include <ranges>
+#include <string_view>
+#include <zlib.h>
+
+namespace {
+namespace json = boost::json;
+using ssimp::img::elem_type;
+
+constexpr std::string_view magic = "SSIMPCHK";
+constexpr std::size_t length_size = 4;
+constexpr std::size_t table_entry_size = 16;
+
+/**
+ * Size of a single sample of **T**, i.e. the unit whose bytes are reversed
+ * when converting between byte orders.
+ */
+template <typename T>
+constexpr std::size_t sample_size = sizeof(T);
+
+template <typename T>
+constexpr std::size_t sample_size<std::complex<T>> = sizeof(T);
+
+template <std::size_t N>
+constexpr std::size_t sample_size<std::array<std::uint8_t, N>> = 1;
+
+/**
+ * Convert samples of **sample_size** bytes in **bytes** between native and
+ * little endian byte order.
+ */
+void swap_to_little_endian(std::span<std::byte> bytes,
+                           std::size_t sample_size) {
+	if (std::endian::native == std::endian::little || sample_size == 1)
+		return;
+
+	for (std::size_t i = 0; i < bytes.size(); i += sample_size)
+		std::reverse(bytes.begin() + i, bytes.begin() + i + sample_size);
+}
+
+std::size_t product(std::span<const std::size_t> values) {
+	return std::reduce(values.begin(), values.end(), std::size_t(1),
+	                   std::multiplies{});
+}
+
+void append_little_endian(std::vector<std::byte>& out,
+                          std::uint64_t value,
+                          std::size_t bytes) {
+	for (std::size_t i = 0; i < bytes; ++i)
+		out.push_back(std::byte((value >> (8 * i)) & 0xff));
+}
+
+std::uint64_t read_little_endian(std::span<const std::byte> bytes) {
+	std::uint64_t value = 0;
+	for (std::size_t i = 0; i < bytes.size(); ++i)
+		value |= std::uint64_t(bytes[i]) << (8 * i);
+	return value;
+}
+
+/**
+ * Layout of the stored image.
+ */
+struct Metadata {
+	elem_type type;
+	std::vector<std::size_t> dims;
+	std::vector<std::size_t> chunk_dims;
+
+	/**
+	 * Number of chunks along every axis.
+	 */
+	std::vector<std::size_t> grid() const {
+		std::vector<std::size_t> out;
+		for (std::size_t i = 0; i < dims.size(); ++i)
+			out.push_back((dims[i] + chunk_dims[i] - 1) / chunk_dims[i]);
+		return out;
+	}
+};
+
+/**
+ * Axis aligned box of elements.
+ */
+struct Box {
+	std::vector<std::size_t> origin;
+	std::vector<std::size_t> size;
+};
+
+/**
+ * Elements covered by chunk at **index** of **grid**, cropped to the image.
+ */
+Box chunk_box(const Metadata& meta,
+              std::span<const std::size_t> grid,
+              std::size_t index) {
+	Box out;
+	for (std::size_t i = 0; i < grid.size(); ++i) {
+		std::size_t origin = (index % grid[i]) * meta.chunk_dims[i];
+		out.origin.push_back(origin);
+		out.size.push_back(std::min(meta.chunk_dims[i], meta.dims[i] - origin));
+		index /= grid[i];
+	}
+	return out;
+}
+
+/**
+ * Copy box of **size** elements of **elem_size** bytes from **src_origin** of
+ * array with **src_dims** to **dst_origin** of array with **dst_dims**. Both
+ * arrays have the first coordinate changing fastest, so the box is copied by
+ * rows along the first axis.
+ */
+void copy_box(const std::byte* src,
+              std::span<const std::size_t> src_dims,
+              std::span<const std::size_t> src_origin,
+              std::byte* dst,
+              std::span<const std::size_t> dst_dims,
+              std::span<const std::size_t> dst_origin,
+              std::span<const std::size_t> size,
+              std::size_t elem_size) {
+	if (product(size) == 0)
+		return;
+
+	std::vector<std::size_t> pos(size.size(), 0);
+	while (true) {
+		std::size_t src_idx = 0;
+		std::size_t dst_idx = 0;
+		std::size_t src_mult = 1;
+		std::size_t dst_mult = 1;
+		for (std::size_t i = 0; i < size.size(); ++i) {
+			src_idx += (src_origin[i] + pos[i]) * src_mult;
+			dst_idx += (dst_origin[i] + pos[i]) * dst_mult;
+			src_mult *= src_dims[i];
+			dst_mult *= dst_dims[i];
+		}
+		std::memcpy(dst + dst_idx * elem_size, src + src_idx * elem_size,
+		            size[0] * elem_size);
+
+		std::size_t axis = 1;
+		for (; axis < size.size(); ++axis) {
+			if (++pos[axis] < size[axis])
+				break;
+			pos[axis] = 0;
+		}
+		if (axis == size.size())
+			return;
+	}
+}
+
+std::vector<std::size_t> to_dims(const json::value& value) {
+	std::vector<std::size_t> out;
+	for (const json::value& dim : value.as_array())
+		out.push_back(dim.to_number<std::size_t>());
+	return out;
+}
+
+/**
+ * Parse metadata at the beginning of **bytes**, return them together with the
+ * offset of chunk table. Return nothing if **bytes** do not start with valid
+ * metadata.
+ */
+std::optional<std::pair<Metadata, std::size_t>>
+parse_metadata(std::span<const std::byte> bytes) {
+	std::size_t text_offset = magic.size() + length_size;
+	if (bytes.size() < text_offset ||
+	    !std::ranges::equal(std::as_bytes(std::span(magic)),
+	                        bytes.first(magic.size())))
+		return {};
+
+	std::size_t text_length =
+	    read_little_endian(bytes.subspan(magic.size(), length_size));
+	if (bytes.size() - text_offset < text_length)
+		return {};
+	std::string_view text(
+	    reinterpret_cast<const char*>(bytes.data() + text_offset), text_length);
+
+	Metadata meta{};
+	try {
+		const json::object root = json::parse(text).as_object();
+		if (std::string_view(root.at("compression").as_string()) != "zlib")
+			return {};
+
+		std::string_view type = root.at("type").as_string();
+		auto types = std::views::iota(
+		    0, int(std::tuple_size_v<ssimp::img::type_list>));
+		auto found = std::ranges::find_if(types, [&](int i) {
+			return ssimp::to_string(elem_type(i)) == type;
+		});
+		if (found == types.end())
+			return {};
+		meta.type = elem_type(*found);
+
+		meta.dims = to_dims(root.at("dims"));
+		meta.chunk_dims = to_dims(root.at("chunk_dims"));
+	} catch (const std::exception&) {
+		return {};
+	}
+
+	if (meta.dims.empty() || meta.dims.size() != meta.chunk_dims.size() ||
+	    std::ranges::count(meta.chunk_dims, 0) != 0)
+		return {};
+
+	std::size_t table_offset = text_offset + text_length;
+	if ((bytes.size() - table_offset) / table_entry_size <
+	    product(meta.grid()))
+		return {};
+
+	return std::pair{std::move(meta), table_offset};
+}
+
+/**
+ * Region of the image requested by loading **options**.
+ */
+Box requested_region(const Metadata& meta,
+                     const ssimp::option_types::options_t& options) {
+	Box region{std::vector<std::size_t>(meta.dims.size(), 0), meta.dims};
+	if (!std::get<bool>(options.at("region")))
+		return region;
+
+	constexpr std::array offset_ids{"region_x", "region_y", "region_z"};
+	constexpr std::array size_ids{"region_width", "region_height",
+	                              "region_depth"};
+	for (std::size_t axis = 0; axis < offset_ids.size(); ++axis) {
+		std::size_t offset =
+		    std::size_t(std::get<int32_t>(options.at(offset_ids[axis])));
+		std::size_t size =
+		    std::size_t(std::get<int32_t>(options.at(size_ids[axis])));
+
+		if (axis >= meta.dims.size()) {
+			if (offset != 0 || size > 1)
+				throw ssimp::exceptions::Unsupported(
+				    "Region is outside of the image");
+			continue;
+		}
+
+		std::size_t dim = meta.dims[axis];
+		if (offset >= dim)
+			throw ssimp::exceptions::Unsupported(
+			    "Region is outside of the image");
+		size = size == 0 ? dim - offset : size;
+		if (size > dim - offset)
+			throw ssimp::exceptions::Unsupported(
+			    "Region is outside of the image");
+
+		region.origin[axis] = offset;
+		region.size[axis] = size;
+	}
+	return region;
+}
+
+/**
+ * Decompress all chunks overlapping **region** of image of type **T** stored
+ * in **bytes**, return nothing if any chunk is corrupted.
+ */
+template <typename T>
+std::optional<ssimp::img::ndImageBase>
+load_region(const Metadata& meta,
+            std::span<const std::byte> bytes,
+            std::size_t table_offset,
+            const Box& region,
+            std::size_t threads) {
+	std::vector<std::size_t> grid = meta.grid();
+	std::size_t rank = grid.size();
+
+	std::vector<std::size_t> needed;
+	for (std::size_t i = 0; i < product(grid); ++i) {
+		Box chunk = chunk_box(meta, grid, i);
+		bool overlaps = true;
+		for (std::size_t axis = 0; axis < rank; ++axis)
+			overlaps = overlaps &&
+			           chunk.origin[axis] <
+			               region.origin[axis] + region.size[axis] &&
+			           region.origin[axis] <
+			               chunk.origin[axis] + chunk.size[axis];
+		if (overlaps)
+			needed.push_back(i);
+	}
+
+	ssimp::img::ndImage<T> out(region.size);
+	std::byte* out_data = std::as_writable_bytes(out.span()).data();
+	std::atomic<bool> valid = true;
+
+	auto load_chunk = [&](std::size_t i) {
+		std::span<const std::byte> entry =
+		    bytes.subspan(table_offset + needed[i] * table_entry_size);
+		std::uint64_t offset = read_little_endian(entry.first(8));
+		std::uint64_t size = read_little_endian(entry.subspan(8, 8));
+		if (offset > bytes.size() || size > bytes.size() - offset) {
+			valid = false;
+			return;
+		}
+
+		Box chunk = chunk_box(meta, grid, needed[i]);
+		std::vector<std::byte> raw(product(chunk.size) * sizeof(T));
+		uLongf raw_size = uLongf(raw.size());
+		if (uncompress(reinterpret_cast<Bytef*>(raw.data()), &raw_size,
+		               reinterpret_cast<const Bytef*>(bytes.data() + offset),
+		               uLong(size)) != Z_OK ||
+		    raw_size != raw.size()) {
+			valid = false;
+			return;
+		}
+
+		std::vector<std::size_t> src_origin(rank);
+		std::vector<std::size_t> dst_origin(rank);
+		std::vector<std::size_t> overlap(rank);
+		for (std::size_t axis = 0; axis < rank; ++axis) {
+			std::size_t lo = std::max(chunk.origin[axis], region.origin[axis]);
+			std::size_t hi =
+			    std::min(chunk.origin[axis] + chunk.size[axis],
+			             region.origin[axis] + region.size[axis]);
+			src_origin[axis] = lo - chunk.origin[axis];
+			dst_origin[axis] = lo - region.origin[axis];
+			overlap[axis] = hi - lo;
+		}
+		copy_box(raw.data(), chunk.size, src_origin, out_data, region.size,
+		         dst_origin, overlap, sizeof(T));
+	};
+	ssimp::parallel::parallel_for(needed.size(), load_chunk, threads);
+
+	if (!valid)
+		return {};
+	swap_to_little_endian(std::as_writable_bytes(out.span()), sample_size<T>);
+	return out;
+}
+
+/**
+ * Call **load_region** with the type given by **meta**.
+ */
+template <typename... types_t>
+std::optional<ssimp::img::ndImageBase>
+load_any_region(std::tuple<types_t...>*,
+                const Metadata& meta,
+                std::span<const std::byte> bytes,
+                std::size_t table_offset,
+                const Box& region,
+                std::size_t threads) {
+	std::optional<ssimp::img::ndImageBase> out;
+	((meta.type == ssimp::img::type_to_enum<types_t>
+	      ? (out = load_region<types_t>(meta, bytes, table_offset, region,
+	                                    threads),
+	         0)
+	      : 0),
+	 ...);
+	return out;
+}
+
+std::optional<std::vector<ssimp::img::LocalizedImage>>
+load_chunked(std::span<const std::byte> bytes,
+             const ssimp::option_types::options_t& options) {
+	auto parsed = parse_metadata(bytes);
+	if (!parsed)
+		return {};
+	const auto& [meta, table_offset] = *parsed;
+
+	Box region = requested_region(meta, options);
+	std::size_t threads = std::size_t(std::get<int32_t>(options.at("threads")));
+	std::optional<ssimp::img::ndImageBase> out =
+	    load_any_region(static_cast<ssimp::img::type_list*>(nullptr), meta,
+	                    bytes, table_offset, region, threads);
+	if (!out)
+		return {};
+	return std::vector<ssimp::img::LocalizedImage>{{*out}};
+}
+
+/**
+ * Compressed image split into the file header (metadata and chunk table) and
+ * individual chunks, their concatenation forms the file.
+ */
+struct EncodedImage {
+	std::vector<std::byte> header;
+	std::vector<std::vector<std::byte>> chunks;
+
+	std::vector<std::span<const std::byte>> parts() const {
+		std::vector<std::span<const std::byte>> out{header};
+		out.insert(out.end(), chunks.begin(), chunks.end());
+		return out;
+	}
+};
+
+/**
+ * Split **img** into chunks and compress them in parallel.
+ */
+template <typename T>
+EncodedImage encode_chunks(const ssimp::img::ndImage<T>& img,
+                           const ssimp::option_types::options_t& options) {
+	std::size_t chunk_size =
+	    std::size_t(std::get<int32_t>(options.at("chunk_size")));
+	int level = std::get<int32_t>(options.at("compression_level"));
+	std::size_t threads = std::size_t(std::get<int32_t>(options.at("threads")));
+
+	Metadata meta{ssimp::img::type_to_enum<T>, img.dims(), {}};
+	for (std::size_t dim : meta.dims)
+		meta.chunk_dims.push_back(std::clamp(dim, std::size_t(1), chunk_size));
+	std::vector<std::size_t> grid = meta.grid();
+
+	EncodedImage out;
+	out.chunks.resize(product(grid));
+	const std::byte* img_data = std::as_bytes(img.span()).data();
+
+	auto encode_chunk = [&](std::size_t i) {
+		Box chunk = chunk_box(meta, grid, i);
+		std::vector<std::byte> raw(product(chunk.size) * sizeof(T));
+		std::vector<std::size_t> origin(chunk.size.size(), 0);
+		copy_box(img_data, meta.dims, chunk.origin, raw.data(), chunk.size,
+		         origin, chunk.size, sizeof(T));
+		swap_to_little_endian(raw, sample_size<T>);
+
+		std::vector<std::byte>& packed = out.chunks[i];
+		uLongf packed_size = compressBound(uLong(raw.size()));
+		packed.resize(packed_size);
+		if (compress2(reinterpret_cast<Bytef*>(packed.data()), &packed_size,
+		              reinterpret_cast<const Bytef*>(raw.data()),
+		              uLong(raw.size()), level) != Z_OK)
+			throw ssimp::exceptions::IOError("Could not compress chunk");
+		packed.resize(packed_size);
+	};
+	ssimp::parallel::parallel_for(out.chunks.size(), encode_chunk, threads);
+
+	json::array dims;
+	json::array chunk_dims;
+	for (std::size_t i = 0; i < meta.dims.size(); ++i) {
+		dims.push_back(std::uint64_t(meta.dims[i]));
+		chunk_dims.push_back(std::uint64_t(meta.chunk_dims[i]));
+	}
+	std::string type = ssimp::to_string(meta.type);
+	std::string text =
+	    json::serialize(json::object{{"type", type.c_str()},
+	                                 {"dims", dims},
+	                                 {"chunk_dims", chunk_dims},
+	                                 {"compression", "zlib"}});
+
+	auto magic_bytes = std::as_bytes(std::span(magic));
+	out.header.assign(magic_bytes.begin(), magic_bytes.end());
+	append_little_endian(out.header, text.size(), length_size);
+	auto text_bytes = std::as_bytes(std::span(text));
+	out.header.insert(out.header.end(), text_bytes.begin(), text_bytes.end());
+
+	std::size_t offset =
+	    out.header.size() + out.chunks.size() * table_entry_size;
+	for (const std::vector<std::byte>& chunk : out.chunks) {
+		append_little_endian(out.header, offset, 8);
+		append_little_endian(out.header, chunk.size(), 8);
+		offset += chunk.size();
+	}
+	return out;
+}
+} // namespace
+
+namespace ssimp::formats {
+/* static */ bool Chunked::image_count_supported(std::size_t count) {
+	return count == 1;
+}
+
+/* static */ bool
+Chunked::image_dims_supported(std::span<const std::size_t> dims) {
+	return !dims.empty();
+}
+
+/* static */ std::optional<ImageProperties>
+Chunked::get_information(const std::filesystem::path& path,
+                         const option_types::options_t& options) {
+	details::MappedFile file(path);
+	auto parsed = parse_metadata(file.bytes());
+	if (!parsed)
+		return {};
+	const Metadata& meta = parsed->first;
+
+	ImageProperties out{name, meta.dims, {}};
+	out.others["Element type"] = to_string(meta.type);
+
+	std::string chunk_dims;
+	for (std::size_t dim : meta.chunk_dims)
+		chunk_dims += (chunk_dims.empty() ? "" : " x ") + std::to_string(dim);
+	out.others["Chunk dimensions"] = chunk_dims;
+	out.others["Chunks"] = std::to_string(product(meta.grid()));
+	return out;
+}
+
+/* static */ std::optional<std::vector<img::LocalizedImage>>
+Chunked::load_image(const std::filesystem::path& path,
+                    const option_types::options_t& options) {
+	details::MappedFile file(path);
+	return load_chunked(file.bytes(), options);
+}
+
+/* static */ std::optional<std::vector<img::LocalizedImage>>
+Chunked::load_image_from_memory(std::span<const std::byte> bytes,
+                                const option_types::options_t& options) {
+	return load_chunked(bytes, options);
+}
+
+template <typename T>
+    requires mt::traits::is_any_of_tuple_v<T, Chunked::supported_types>
+/* static */ void
+Chunked::save_image(const std::vector<img::ndImage<T>>& imgs,
+                    const std::filesystem::path& path,
+                    const option_types::options_t& options) {
+	EncodedImage encoded = encode_chunks(imgs[0], options);
+	details::save_file(path, encoded.parts());
+}
+
+template <typename T>
+    requires mt::traits::is_any_of_tuple_v<T, Chunked::supported_types>
+/* static */ std::vector<std::byte>
+Chunked::encode_image(const std::vector<img::ndImage<T>>& imgs,
+                      const option_types::options_t& options) {
+	EncodedImage encoded = encode_chunks(imgs[0], options);
+	std::vector<std::byte> out;
+	for (std::span<const std::byte> part : encoded.parts())
+		out.insert(out.end(), part.begin(), part.end());
+	return out;
+}
+
+INSTANTIATE_SAVE_TEMPLATE(Chunked, img::GRAY_8);
+INSTANTIATE_SAVE_TEMPLATE(Chunked, img::GRAYA_8);
+INSTANTIATE_SAVE_TEMPLATE(Chunked, img::GRAY_16);
+INSTANTIATE_SAVE_TEMPLATE(Chunked, img::GRAY_32);
+INSTANTIATE_SAVE_TEMPLATE(Chunked, img::GRAY_64);
+INSTANTIATE_SAVE_TEMPLATE(Chunked, img::FLOAT);
+INSTANTIATE_SAVE_TEMPLATE(Chunked, img::DOUBLE);
+INSTANTIATE_SAVE_TEMPLATE(Chunked, img::RGB_8);
+INSTANTIATE_SAVE_TEMPLATE(Chunked, img::RGBA_8);
+INSTANTIATE_SAVE_TEMPLATE(Chunked, img::COMPLEX_F);
+INSTANTIATE_SAVE_TEMPLATE(Chunked, img::COMPLEX_D);
+
+} // namespace ssimp::formats
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "common.hpp"
+
+namespace ssimp::formats {
+/**
+ * Container for large nD images (e.g. 3D stacks). The image is split into a
+ * grid of fixed size chunks compressed independently with zlib, so chunks are
+ * compressed and decompressed in parallel and loading a region touches only
+ * the chunks overlapping it.
+ *
+ * The file starts with magic "SSIMPCHK", 32-bit little endian length of JSON
+ * metadata (element type, dimensions and chunk dimensions) and the metadata
+ * itself, followed by a table of 64-bit little endian (offset, size) pairs of
+ * all chunks and by the compressed chunks. Chunks are ordered with the first
+ * chunk coordinate changing fastest; chunks on the upper borders are cropped
+ * to the image. Samples are stored little endian.
+ */
+class Chunked {
+  public:
+	using supported_types = img::type_list;
+	constexpr static const char* name = "chunked";
+
+	static bool image_count_supported(std::size_t count);
+	static bool image_dims_supported(std::span<const std::size_t> dims);
+	static constexpr bool same_dims_required() { return true; }
+
+	static std::optional<ImageProperties>
+	get_information(const std::filesystem::path& path,
+	                const option_types::options_t& options);
+
+	/**
+	 * The file is memory mapped and only chunks overlapping the requested
+	 * region are decompressed.
+	 */
+	static std::optional<std::vector<img::LocalizedImage>>
+	load_image(const std::filesystem::path& path,
+	           const option_types::options_t& options);
+
+	static std::optional<std::vector<img::LocalizedImage>>
+	load_image_from_memory(std::span<const std::byte> bytes,
+	                       const option_types::options_t& options);
+
+	template <typename T>
+	    requires mt::traits::is_any_of_tuple_v<T, Chunked::supported_types>
+	static void save_image(const std::vector<img::ndImage<T>>& imgs,
+	                       const std::filesystem::path& path,
+	                       const option_types::options_t& options);
+
+	template <typename T>
+	    requires mt::traits::is_any_of_tuple_v<T, Chunked::supported_types>
+	static std::vector<std::byte>
+	encode_image(const std::vector<img::ndImage<T>>& imgs,
+	             const option_types::options_t& options);
+};
+} // namespace ssimp::formats
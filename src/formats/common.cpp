@@ -0,0 +1,43 @@
+#include "common.hpp"
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+namespace bip = boost::interprocess;
+
+namespace ssimp::formats::details {
+struct MappedFile::_impl_t {
+	bip::file_mapping mapping;
+	bip::mapped_region region;
+};
+
+MappedFile::MappedFile(const fs::path& path, bool copy_on_write)
+    : _copy_on_write(copy_on_write) {
+	std::error_code ec;
+	std::uintmax_t size = fs::file_size(path, ec);
+	if (ec)
+		throw exceptions::IOError(std::format("Could not map '{}': {}",
+		                                      path.string(), ec.message()));
+
+	// empty files can not be mapped
+	if (size == 0)
+		return;
+
+	try {
+		_impl = std::make_unique<_impl_t>();
+		_impl->mapping = bip::file_mapping(path.string().c_str(),
+		                                   bip::read_only);
+		bip::mode_t mode = copy_on_write ? bip::copy_on_write : bip::read_only;
+		_impl->region = bip::mapped_region(_impl->mapping, mode);
+	} catch (const bip::interprocess_exception& e) {
+		throw exceptions::IOError(
+		    std::format("Could not map '{}': {}", path.string(), e.what()));
+	}
+
+	_bytes = {static_cast<const std::byte*>(_impl->region.get_address()),
+	          _impl->region.get_size()};
+}
+
+MappedFile::MappedFile(MappedFile&&) noexcept = default;
+MappedFile& MappedFile::operator=(MappedFile&&) noexcept = default;
+MappedFile::~MappedFile() = default;
+} // namespace ssimp::formats::details
@@ -4,13 +4,20 @@
 #include "../application/meta_types.hpp"
 #include "../application/nd_image.hpp"
 #include "../application/utils.hpp"
+#include <atomic>
+#include <cassert>
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <filesystem>
 #include <format>
 #include <fstream>
 #include <iostream>
+#include <iterator>
+#include <memory>
 #include <optional>
 #include <ostream>
+#include <random>
 #include <span>
 #include <utility>
 #include <vector>
@@ -18,23 +25,188 @@
 namespace fs = std::filesystem;
 
 namespace ssimp::formats::details {
+/**
+ * Read content of the file at **path** using a single read into a buffer of
+ * the final size. When **bytes** is non-zero, at most **bytes** bytes are read.
+ */
 inline std::vector<std::byte> read_file(const fs::path& path,
                                         std::size_t bytes = 0) {
 	std::ifstream file(path, std::ios::binary);
+	if (!file)
+		throw exceptions::IOError(
+		    std::format("Could not open '{}' for reading", path.string()));
+
+	std::error_code ec;
+	std::uintmax_t size = fs::file_size(path, ec);
 	std::vector<std::byte> out;
 
-	while (file.good() && (bytes == 0 || out.size() < bytes))
-		out.push_back(std::byte(file.get()));
+	if (ec) {
+		// not a regular file, size is not known upfront
+		std::vector<char> content(std::istreambuf_iterator<char>(file), {});
+		if (bytes != 0 && content.size() > bytes)
+			content.resize(bytes);
+		out.resize(content.size());
+		std::memcpy(out.data(), content.data(), content.size());
+		return out;
+	}
+
+	if (bytes != 0 && size > bytes)
+		size = bytes;
+
+	out.resize(std::size_t(size));
+	file.read(reinterpret_cast<char*>(out.data()),
+	          static_cast<std::streamsize>(out.size()));
+	out.resize(std::size_t(file.gcount()));
 
 	return out;
 }
 
-inline void save_file(const fs::path& path, std::span<const std::byte> bytes) {
-	fs::create_directories(path.parent_path());
+/**
+ * Memory mapping of a whole file. Preferred over **read_file** when the
+ * content is only inspected, as no copy is made.
+ *
+ * With **copy_on_write** the mapping is private and writable: pages are
+ * shared with the file until they are modified, the file itself never
+ * changes.
+ */
+class MappedFile {
+  public:
+	explicit MappedFile(const fs::path& path, bool copy_on_write = false);
+	MappedFile(MappedFile&&) noexcept;
+	MappedFile& operator=(MappedFile&&) noexcept;
+	~MappedFile();
+
+	/**
+	 * Mapped content, valid for the lifetime of the object.
+	 */
+	std::span<const std::byte> bytes() const { return _bytes; }
+
+	/**
+	 * Mapped content which may be modified, only for **copy_on_write**
+	 * mappings.
+	 */
+	std::span<std::byte> writable_bytes() {
+		assert(_copy_on_write);
+		return {const_cast<std::byte*>(_bytes.data()), _bytes.size()};
+	}
+
+  private:
+	struct _impl_t;
+	std::unique_ptr<_impl_t> _impl;
+	std::span<const std::byte> _bytes;
+	bool _copy_on_write;
+};
+
+/**
+ * Writer which writes into a temporary file next to **path** and replaces
+ * **path** only after **commit()**, so readers never see a partially written
+ * file. Uncommitted writes are discarded on destruction.
+ */
+class AtomicFileWriter {
+  public:
+	explicit AtomicFileWriter(const fs::path& path) : _path(path) {
+		if (!_path.parent_path().empty())
+			fs::create_directories(_path.parent_path());
+
+		_tmp_path = _path;
+		_tmp_path += std::format(".{}.tmp", _unique_suffix());
+
+		_buffer.resize(_buffer_size);
+		_file.rdbuf()->pubsetbuf(_buffer.data(),
+		                         static_cast<std::streamsize>(_buffer.size()));
+		_file.open(_tmp_path, std::ios::binary | std::ios::trunc);
+		if (!_file)
+			throw exceptions::IOError(std::format(
+			    "Could not open '{}' for writing", _tmp_path.string()));
+	}
+
+	AtomicFileWriter(const AtomicFileWriter&) = delete;
+	AtomicFileWriter& operator=(const AtomicFileWriter&) = delete;
 
-	std::ofstream file(path, std::ios::binary);
+	~AtomicFileWriter() {
+		if (_committed)
+			return;
+		_file.close();
+		std::error_code ec;
+		fs::remove(_tmp_path, ec);
+	}
+
+	/**
+	 * Append **bytes** to the file.
+	 */
+	void write(std::span<const std::byte> bytes) {
+		_file.write(reinterpret_cast<const char*>(bytes.data()),
+		            static_cast<std::streamsize>(bytes.size()));
+		if (!_file)
+			throw exceptions::IOError(
+			    std::format("Could not write to '{}'", _tmp_path.string()));
+	}
+
+	/**
+	 * Flush the content and move it in place of the target file.
+	 */
+	void commit() {
+		_file.close();
+		if (!_file)
+			throw exceptions::IOError(
+			    std::format("Could not write to '{}'", _tmp_path.string()));
+
+		std::error_code ec;
+		fs::rename(_tmp_path, _path, ec);
+		if (ec)
+			throw exceptions::IOError(
+			    std::format("Could not replace '{}': {}", _path.string(),
+			                ec.message()));
+		_committed = true;
+	}
+
+	/**
+	 * Stream the data are written to, for formats which produce their output
+	 * incrementally.
+	 */
+	std::ostream& stream() { return _file; }
+
+  private:
+	/**
+	 * Suffix unique among all processes: random value drawn once per process
+	 * and counter of writers in this process.
+	 */
+	static std::string _unique_suffix() {
+		static const std::uint64_t process = [] {
+			std::random_device device;
+			return std::uint64_t(device()) << 32 | device();
+		}();
+		static std::atomic<std::size_t> counter = 0;
+		return std::format("{:016x}.{}", process, counter++);
+	}
+
+	static constexpr std::size_t _buffer_size = 1 << 20;
+
+	fs::path _path;
+	fs::path _tmp_path;
+	std::vector<char> _buffer;
+	std::ofstream _file;
+	bool _committed = false;
+};
+
+/**
+ * Atomically replace the file at **path** with **bytes**.
+ */
+inline void save_file(const fs::path& path, std::span<const std::byte> bytes) {
+	AtomicFileWriter writer(path);
+	writer.write(bytes);
+	writer.commit();
+}
 
-	for (auto byte : bytes)
-		file.put(static_cast<unsigned char>(byte));
+/**
+ * Atomically replace the file at **path** with concatenation of **parts**,
+ * without joining them in memory first.
+ */
+inline void save_file(const fs::path& path,
+                      std::span<const std::span<const std::byte>> parts) {
+	AtomicFileWriter writer(path);
+	for (auto part : parts)
+		writer.write(part);
+	writer.commit();
 }
 } // namespace ssimp::formats::details
@@ -4,4 +4,7 @@
 #define INSTANTIATE_SAVE_TEMPLATE(format, type)                                \
 	template void format::save_image(                                          \
 	    const std::vector<::ssimp::img::ndImage<type>>&, const fs::path&,      \
+	    const ::ssimp::option_types::options_t&);                              \
+	template std::vector<std::byte> format::encode_image(                      \
+	    const std::vector<::ssimp::img::ndImage<type>>&,                       \
 	    const ::ssimp::option_types::options_t&);
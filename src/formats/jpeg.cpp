@@ -1,9 +1,140 @@
 #include "jpeg.hpp"
 #include "common_macro.hpp"
+#include "../application/parallel.hpp"
 
+#include <algorithm>
+#include <array>
+#include <climits>
+#include <cmath>
+#include <csetjmp>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
 #include <turbojpeg.h>
+#include <unordered_map>
+
+// jpeglib.h requires FILE and size_t to be declared
+#include <jpeglib.h>
 
 namespace {
+struct TjHandleDeleter {
+	void operator()(void* handle) const { tjDestroy(handle); }
+};
+
+struct TjBufferDeleter {
+	void operator()(unsigned char* buffer) const { tjFree(buffer); }
+};
+
+using tj_handle_t = std::unique_ptr<void, TjHandleDeleter>;
+using tj_buffer_t = std::unique_ptr<unsigned char, TjBufferDeleter>;
+
+/**
+ * Decompressor owned by the calling thread, created on first use (or
+ * again after a failed attempt).
+ */
+tjhandle thread_decompressor() {
+	thread_local tj_handle_t handle;
+	if (!handle)
+		handle.reset(tjInitDecompress());
+	if (!handle)
+		throw ssimp::exceptions::IOError(std::format(
+		    "Jpeg decompressor error: '{}'", tjGetErrorStr2(nullptr)));
+	return handle.get();
+}
+
+/**
+ * Compressor owned by the calling thread, created on first use (or
+ * again after a failed attempt).
+ */
+tjhandle thread_compressor() {
+	thread_local tj_handle_t handle;
+	if (!handle)
+		handle.reset(tjInitCompress());
+	if (!handle)
+		throw ssimp::exceptions::IOError(std::format(
+		    "Jpeg compressor error: '{}'", tjGetErrorStr2(nullptr)));
+	return handle.get();
+}
+
+/**
+ * Transformer owned by the calling thread, created on first use (or
+ * again after a failed attempt).
+ */
+tjhandle thread_transformer() {
+	thread_local tj_handle_t handle;
+	if (!handle)
+		handle.reset(tjInitTransform());
+	if (!handle)
+		throw ssimp::exceptions::IOError(std::format(
+		    "Jpeg transformer error: '{}'", tjGetErrorStr2(nullptr)));
+	return handle.get();
+}
+
+// largest output buffer kept by a thread for the next image
+constexpr unsigned long _retained_buffer_size = 64ul << 20;
+
+/**
+ * Output buffer of the compressor for at least **size** bytes. The buffer of
+ * the calling thread is reused, so encoding images of similar size does not
+ * allocate, unless it is larger than **_retained_buffer_size** after use.
+ * Sizes which tjAlloc can not take are left to the compressor to allocate.
+ */
+class CompressBuffer {
+  public:
+	explicit CompressBuffer(unsigned long size) {
+		if (size > static_cast<unsigned long>(INT_MAX))
+			return;
+
+		Retained& retained = thread_retained();
+		if (size > retained.capacity) {
+			retained.buffer.reset(tjAlloc(static_cast<int>(size)));
+			retained.capacity = retained.buffer ? size : 0;
+			if (!retained.buffer)
+				throw std::bad_alloc();
+		}
+		_data = retained.buffer.get();
+		_retained = true;
+	}
+
+	CompressBuffer(const CompressBuffer&) = delete;
+	CompressBuffer& operator=(const CompressBuffer&) = delete;
+
+	~CompressBuffer() {
+		if (!_retained) {
+			tjFree(_data);
+			return;
+		}
+
+		Retained& retained = thread_retained();
+		if (retained.capacity > _retained_buffer_size) {
+			retained.buffer.reset();
+			retained.capacity = 0;
+		}
+	}
+
+	/**
+	 * Pointer to pass to the compressor, which may replace it by its own
+	 * buffer if **flags** allow it.
+	 */
+	unsigned char*& data() { return _data; }
+	int flags() const { return _retained ? TJFLAG_NOREALLOC : 0; }
+
+  private:
+	struct Retained {
+		tj_buffer_t buffer;
+		unsigned long capacity = 0;
+	};
+
+	static Retained& thread_retained() {
+		thread_local Retained retained;
+		return retained;
+	}
+
+	unsigned char* _data = nullptr;
+	bool _retained = false;
+};
+
 class JpegMeta {
   public:
 	int width;
@@ -81,6 +212,24 @@ TJSAMP samp_from_string(std::string_view sv) {
 	throw std::runtime_error("Invalid value");
 }
 
+/**
+ * Smallest scaling factor supported by the decoder, which is not smaller than
+ * **factor**.
+ */
+tjscalingfactor scaling_factor(double factor) {
+	int count = 0;
+	const tjscalingfactor* factors = tjGetScalingFactors(&count);
+	tjscalingfactor best{1, 1};
+
+	for (int i = 0; i < count; ++i) {
+		double value = double(factors[i].num) / factors[i].denom;
+		if (value >= factor &&
+		    value < double(best.num) / best.denom)
+			best = factors[i];
+	}
+	return best;
+}
+
 template <typename T>
 std::pair<ssimp::img::ndImageBase, unsigned char*> get_image(int width,
                                                              int height) {
@@ -88,11 +237,495 @@ std::pair<ssimp::img::ndImageBase, unsigned char*> get_image(int width,
 
 	return {img, reinterpret_cast<unsigned char*>(img.span().data())};
 }
+
+/**
+ * Decode **bytes** to separate Y, Cb and Cr planes without color conversion.
+ * Chroma planes keep their subsampled dimensions.
+ */
+std::optional<std::vector<ssimp::img::LocalizedImage>>
+decode_yuv_planes(tjhandle decompressor,
+                  std::span<const std::byte> bytes,
+                  int width,
+                  int height,
+                  TJSAMP subsampling) {
+	int plane_count = subsampling == TJSAMP_GRAY ? 1 : 3;
+	std::vector<ssimp::img::LocalizedImage> out;
+	std::array<unsigned char*, 3> planes{};
+
+	for (int i = 0; i < plane_count; ++i) {
+		auto [img, ptr] = get_image<ssimp::img::GRAY_8>(
+		    tjPlaneWidth(i, width, subsampling),
+		    tjPlaneHeight(i, height, subsampling));
+		out.push_back({img, std::array{"y", "cb", "cr"}[i]});
+		planes[i] = ptr;
+	}
+
+	if (tjDecompressToYUVPlanes(
+	        decompressor, reinterpret_cast<const unsigned char*>(bytes.data()),
+	        bytes.size(), planes.data(), width, nullptr, height, 0))
+		return {};
+
+	return out;
+}
+
+/**
+ * Derive chroma subsampling from dimensions of luma and chroma planes. The
+ * chroma planes of the subsampling are matched exactly if possible, otherwise
+ * they may differ by one pixel in each dimension (processing the planes
+ * independently may change rounding of chroma dimensions).
+ */
+TJSAMP subsampling_from_planes(std::span<const std::size_t> luma,
+                               std::span<const std::size_t> chroma) {
+	auto distance = [](std::size_t a, int b) {
+		return a > std::size_t(b) ? a - std::size_t(b) : std::size_t(b) - a;
+	};
+
+	std::optional<TJSAMP> out;
+	std::size_t best = 0;
+	for (TJSAMP subsampling :
+	     {TJSAMP_444, TJSAMP_422, TJSAMP_420, TJSAMP_440, TJSAMP_411}) {
+		std::size_t horizontal = distance(
+		    chroma[0], tjPlaneWidth(1, int(luma[0]), subsampling));
+		std::size_t vertical = distance(
+		    chroma[1], tjPlaneHeight(1, int(luma[1]), subsampling));
+		if (horizontal <= 1 && vertical <= 1 &&
+		    (!out || horizontal + vertical < best)) {
+			out = subsampling;
+			best = horizontal + vertical;
+		}
+	}
+
+	if (!out)
+		throw ssimp::exceptions::Unsupported(
+		    "Dimensions of Y, Cb and Cr planes do not match any chroma "
+		    "subsampling");
+	return *out;
+}
+
+/**
+ * Return **plane** with exactly **width** x **height** pixels, the edge
+ * pixels are replicated or the plane is cropped if needed.
+ */
+std::vector<unsigned char>
+fit_plane(const ssimp::img::ndImage<ssimp::img::GRAY_8>& plane,
+          std::size_t width,
+          std::size_t height) {
+	std::size_t src_width = plane.dims()[0];
+	std::size_t src_height = plane.dims()[1];
+	std::vector<unsigned char> out(width * height);
+
+	for (std::size_t y = 0; y < height; ++y) {
+		const auto* src_row =
+		    plane.data() + std::min(y, src_height - 1) * src_width;
+		for (std::size_t x = 0; x < width; ++x)
+			out[y * width + x] = src_row[std::min(x, src_width - 1)];
+	}
+	return out;
+}
+
+/**
+ * libjpeg error manager which jumps back to the decoding function instead of
+ * terminating the program.
+ */
+struct JpegErrorManager {
+	jpeg_error_mgr pub;
+	std::jmp_buf jump;
+};
+
+[[noreturn]] void jpeg_error_exit(j_common_ptr cinfo) {
+	std::longjmp(reinterpret_cast<JpegErrorManager*>(cinfo->err)->jump, 1);
+}
+
+void jpeg_silent_output(j_common_ptr) {}
+
+/**
+ * Output of libjpeg memory destination, released on destruction.
+ */
+struct EncodedStrip {
+	unsigned char* data = nullptr;
+	unsigned long size = 0;
+
+	EncodedStrip() = default;
+	EncodedStrip(const EncodedStrip&) = delete;
+	EncodedStrip& operator=(const EncodedStrip&) = delete;
+	~EncodedStrip() { std::free(data); }
+};
+
+/**
+ * Encode **height** rows of **pixels** as a standalone JPEG with restart
+ * marker after every MCU row. Strips of the same width encoded with the same
+ * settings share all headers (default Huffman tables are used), so their
+ * entropy coded segments can be concatenated.
+ *
+ * **out** is allocated upfront with the worst case size given by TurboJPEG,
+ * so libjpeg never reallocates (and frees) it and the pointer in **out** stays
+ * valid also when an error jumps out of the encoder.
+ *
+ * No objects with non-trivial destructor may be created after setjmp here.
+ */
+bool encode_strip(const unsigned char* pixels,
+                  JDIMENSION width,
+                  JDIMENSION height,
+                  TJSAMP subsampling,
+                  int quality,
+                  EncodedStrip& out) {
+	bool gray = subsampling == TJSAMP_GRAY;
+	std::size_t row_size = std::size_t(width) * (gray ? 1 : 3);
+
+	unsigned long capacity = tjBufSize(int(width), int(height), subsampling);
+	if (capacity == static_cast<unsigned long>(-1))
+		return false;
+	auto* presized = static_cast<unsigned char*>(std::malloc(capacity));
+	if (!presized)
+		return false;
+	std::free(out.data);
+	out.data = presized;
+	out.size = capacity;
+
+	jpeg_compress_struct cinfo;
+	JpegErrorManager error;
+	cinfo.err = jpeg_std_error(&error.pub);
+	error.pub.error_exit = jpeg_error_exit;
+	error.pub.output_message = jpeg_silent_output;
+
+	jpeg_create_compress(&cinfo);
+	if (setjmp(error.jump)) {
+		jpeg_destroy_compress(&cinfo);
+		return false;
+	}
+
+	jpeg_mem_dest(&cinfo, &out.data, &out.size);
+	cinfo.image_width = width;
+	cinfo.image_height = height;
+	cinfo.input_components = gray ? 1 : 3;
+	cinfo.in_color_space = gray ? JCS_GRAYSCALE : JCS_RGB;
+	jpeg_set_defaults(&cinfo);
+	jpeg_set_quality(&cinfo, quality, TRUE);
+	// as TurboJPEG does, so the strips match the serial encoder
+	cinfo.dct_method = quality >= 96 ? JDCT_ISLOW : JDCT_FASTEST;
+	if (!gray) {
+		cinfo.comp_info[0].h_samp_factor = tjMCUWidth[subsampling] / 8;
+		cinfo.comp_info[0].v_samp_factor = tjMCUHeight[subsampling] / 8;
+	}
+	cinfo.restart_in_rows = 1;
+
+	jpeg_start_compress(&cinfo, TRUE);
+	while (cinfo.next_scanline < cinfo.image_height) {
+		JSAMPROW row = const_cast<JSAMPROW>(
+		    pixels + std::size_t(cinfo.next_scanline) * row_size);
+		jpeg_write_scanlines(&cinfo, &row, 1);
+	}
+	jpeg_finish_compress(&cinfo);
+	jpeg_destroy_compress(&cinfo);
+
+	// not expected, libjpeg frees only buffers it allocated itself
+	if (out.data != presized)
+		std::free(presized);
+	return true;
+}
+
+/**
+ * Return offset of the first entropy coded byte (after SOS segment) and
+ * offset of height field in SOF segment of JPEG **data**.
+ */
+std::pair<std::size_t, std::size_t>
+locate_scan(std::span<const unsigned char> data) {
+	std::size_t sof_height = 0;
+	std::size_t pos = 2; // SOI
+
+	while (pos + 4 <= data.size() && data[pos] == 0xFF) {
+		unsigned char marker = data[pos + 1];
+		std::size_t length = (std::size_t(data[pos + 2]) << 8) | data[pos + 3];
+
+		if (marker >= 0xC0 && marker <= 0xC2)
+			sof_height = pos + 5;
+		if (marker == 0xDA)
+			return {pos + 2 + length, sof_height};
+		pos += 2 + length;
+	}
+
+	throw ssimp::exceptions::IOError("Jpeg encoder produced invalid stream");
+}
+
+/**
+ * Join **strips** produced by **encode_strip** into a single JPEG with
+ * **height** rows. Restart markers are renumbered to form one continuous
+ * sequence and a marker is inserted between the strips.
+ */
+std::vector<std::byte> stitch_strips(std::span<const EncodedStrip> strips,
+                                     std::size_t height) {
+	if (height > 0xFFFF)
+		throw ssimp::exceptions::Unsupported(
+		    "Jpeg height can not exceed 65535 pixels");
+
+	std::vector<unsigned char> out;
+	std::size_t total = 0;
+	for (const auto& strip : strips)
+		total += strip.size + 2;
+	out.reserve(total);
+
+	unsigned next_restart = 0;
+	for (std::size_t i = 0; i < strips.size(); ++i) {
+		std::span<const unsigned char> data(strips[i].data, strips[i].size);
+		auto [scan_begin, sof_height] = locate_scan(data);
+		std::size_t scan_end = data.size() - 2; // EOI
+
+		if (i == 0) {
+			out.insert(out.end(), data.begin(), data.begin() + scan_begin);
+			out[sof_height] = static_cast<unsigned char>(height >> 8);
+			out[sof_height + 1] = static_cast<unsigned char>(height & 0xFF);
+		} else {
+			out.push_back(0xFF);
+			out.push_back(static_cast<unsigned char>(0xD0 + next_restart));
+			next_restart = (next_restart + 1) % 8;
+		}
+
+		std::size_t copied = out.size();
+		out.insert(out.end(), data.begin() + scan_begin,
+		           data.begin() + scan_end);
+
+		// 0xFF in entropy coded data is either stuffed (followed by 0x00) or
+		// starts a restart marker
+		for (std::size_t j = copied; j + 1 < out.size(); ++j) {
+			if (out[j] != 0xFF || out[j + 1] < 0xD0 || out[j + 1] > 0xD7)
+				continue;
+			out[++j] = static_cast<unsigned char>(0xD0 + next_restart);
+			next_restart = (next_restart + 1) % 8;
+		}
+	}
+
+	out.push_back(0xFF);
+	out.push_back(0xD9);
+
+	auto bytes = reinterpret_cast<const std::byte*>(out.data());
+	return std::vector<std::byte>(bytes, bytes + out.size());
+}
+
+/**
+ * Encode **pixels** in horizontal strips of (at least) **strip_height** rows
+ * in parallel and join them using restart markers.
+ */
+std::vector<std::byte> encode_in_strips(const unsigned char* pixels,
+                                        std::size_t width,
+                                        std::size_t height,
+                                        TJSAMP subsampling,
+                                        int quality,
+                                        std::size_t strip_height,
+                                        std::size_t threads) {
+	// strips have to consist of whole MCU rows
+	std::size_t mcu_height = tjMCUHeight[subsampling];
+	strip_height = (strip_height + mcu_height - 1) / mcu_height * mcu_height;
+	std::size_t row_size = width * (subsampling == TJSAMP_GRAY ? 1 : 3);
+
+	std::vector<EncodedStrip> strips((height + strip_height - 1) /
+	                                 strip_height);
+	ssimp::parallel::parallel_for(
+	    strips.size(),
+	    [&](std::size_t i) {
+		    std::size_t first_row = i * strip_height;
+		    std::size_t rows = std::min(strip_height, height - first_row);
+		    if (!encode_strip(pixels + first_row * row_size, width, rows,
+		                      subsampling, quality, strips[i]))
+			    throw ssimp::exceptions::IOError(
+			        "Jpeg compressor error: could not encode strip");
+	    },
+	    threads);
+
+	return stitch_strips(strips, height);
+}
+
+/**
+ * Encode Y, Cb and Cr **imgs** without color conversion, chroma subsampling
+ * is given by dimensions of the planes. The encoded bytes are passed to
+ * **sink** while they are in the compressor buffer.
+ */
+template <typename Sink>
+decltype(auto) encode_yuv_planes(
+    const std::vector<ssimp::img::ndImage<ssimp::img::GRAY_8>>& imgs,
+    int quality,
+    Sink&& sink) {
+	const auto& luma = imgs[0];
+	if (imgs[1].dims() != imgs[2].dims())
+		throw ssimp::exceptions::Unsupported(
+		    "Cb and Cr planes must have the same dimensions");
+
+	TJSAMP subsampling = subsampling_from_planes(luma.dims(), imgs[1].dims());
+	int width = static_cast<int>(luma.dims()[0]);
+	int height = static_cast<int>(luma.dims()[1]);
+
+	// processing (e.g. resizing) the planes independently may have changed
+	// rounding of chroma dimensions
+	std::array<std::vector<unsigned char>, 2> fitted;
+	std::array<const unsigned char*, 3> planes{
+	    reinterpret_cast<const unsigned char*>(luma.data())};
+	for (std::size_t i = 1; i < 3; ++i) {
+		std::size_t plane_width = tjPlaneWidth(int(i), width, subsampling);
+		std::size_t plane_height = tjPlaneHeight(int(i), height, subsampling);
+
+		if (imgs[i].dims()[0] == plane_width &&
+		    imgs[i].dims()[1] == plane_height)
+			planes[i] = reinterpret_cast<const unsigned char*>(imgs[i].data());
+		else {
+			fitted[i - 1] = fit_plane(imgs[i], plane_width, plane_height);
+			planes[i] = fitted[i - 1].data();
+		}
+	}
+
+	unsigned long jpeg_size = tjBufSize(width, height, subsampling);
+	if (jpeg_size == static_cast<unsigned long>(-1))
+		throw ssimp::exceptions::IOError(std::format(
+		    "Jpeg compressor error: '{}'", tjGetErrorStr2(nullptr)));
+	CompressBuffer jpeg_buffer(jpeg_size);
+
+	tjhandle compressor = thread_compressor();
+	if (tjCompressFromYUVPlanes(compressor, planes.data(), width, nullptr,
+	                            height, static_cast<int>(subsampling),
+	                            &jpeg_buffer.data(), &jpeg_size, quality,
+	                            jpeg_buffer.flags()))
+		throw ssimp::exceptions::IOError(std::format(
+		    "Jpeg compressor error: '{}'", tjGetErrorStr2(compressor)));
+
+	return sink(std::span<const std::byte>(
+	    reinterpret_cast<const std::byte*>(jpeg_buffer.data()), jpeg_size));
+}
+
+/**
+ * Decode only **width** x **height** window at (**x**, **y**) of the image
+ * scaled by **factor**. Only iMCU columns covering the window are decoded
+ * and rows above it are skipped without IDCT. The window must lie inside the
+ * scaled image.
+ *
+ * No objects with non-trivial destructor may be created after setjmp here.
+ */
+std::optional<std::vector<ssimp::img::LocalizedImage>>
+decode_region(std::span<const std::byte> bytes,
+              tjscalingfactor factor,
+              bool gray,
+              JDIMENSION x,
+              JDIMENSION y,
+              JDIMENSION width,
+              JDIMENSION height) {
+	jpeg_decompress_struct cinfo;
+	JpegErrorManager error;
+	cinfo.err = jpeg_std_error(&error.pub);
+	error.pub.error_exit = jpeg_error_exit;
+	error.pub.output_message = jpeg_silent_output;
+
+	std::size_t channels = gray ? 1 : 3;
+	ssimp::img::ndImageBase dest_img =
+	    ssimp::img::ndImage<ssimp::img::GRAY_8>(1);
+	unsigned char* dest_ptr = nullptr;
+	if (gray)
+		std::tie(dest_img, dest_ptr) =
+		    get_image<ssimp::img::GRAY_8>(width, height);
+	else
+		std::tie(dest_img, dest_ptr) =
+		    get_image<ssimp::img::RGB_8>(width, height);
+	std::vector<unsigned char> row;
+
+	jpeg_create_decompress(&cinfo);
+	if (setjmp(error.jump)) {
+		jpeg_destroy_decompress(&cinfo);
+		return {};
+	}
+
+	jpeg_mem_src(&cinfo, reinterpret_cast<const unsigned char*>(bytes.data()),
+	             bytes.size());
+	jpeg_read_header(&cinfo, TRUE);
+	cinfo.out_color_space = gray ? JCS_GRAYSCALE : JCS_RGB;
+	cinfo.scale_num = factor.num;
+	cinfo.scale_denom = factor.denom;
+	jpeg_start_decompress(&cinfo);
+
+	// keep one pixel margin, so the chroma upsampling sees the same
+	// neighbours as in full decode, libjpeg extends it to iMCU boundaries
+	JDIMENSION crop_x = x > 0 ? x - 1 : 0;
+	JDIMENSION crop_width =
+	    std::min(x + width + 1, cinfo.output_width) - crop_x;
+	jpeg_crop_scanline(&cinfo, &crop_x, &crop_width);
+	if (y > 0)
+		jpeg_skip_scanlines(&cinfo, y);
+
+	row.resize(std::size_t(crop_width) * channels);
+	std::size_t row_offset = std::size_t(x - crop_x) * channels;
+	std::size_t row_size = std::size_t(width) * channels;
+	for (JDIMENSION i = 0; i < height; ++i) {
+		JSAMPROW row_ptr = row.data();
+		jpeg_read_scanlines(&cinfo, &row_ptr, 1);
+		std::memcpy(dest_ptr + i * row_size, row.data() + row_offset,
+		            row_size);
+	}
+
+	// rest of the image is not needed
+	jpeg_destroy_decompress(&cinfo);
+	return std::vector<ssimp::img::LocalizedImage>{{dest_img}};
+}
+
+/**
+ * Encode **imgs** according to **options** and return the result of
+ * **sink** called with the encoded bytes. Bytes still in the compressor
+ * buffer are passed as a span, bytes joined from strips as a vector.
+ */
+template <typename T, typename Sink>
+decltype(auto) encode(const std::vector<ssimp::img::ndImage<T>>& imgs,
+                      const ssimp::option_types::options_t& options,
+                      Sink&& sink) {
+	if (imgs.size() == 3) {
+		if constexpr (std::is_same_v<T, ssimp::img::GRAY_8>)
+			if (std::get<bool>(options.at("yuv_planes")))
+				return encode_yuv_planes(
+				    imgs, std::get<int32_t>(options.at("quality")), sink);
+
+		throw ssimp::exceptions::Unsupported(
+		    "Three images can only be saved as GRAY_8 Y, Cb and Cr planes "
+		    "(see 'yuv_planes' option)");
+	}
+
+	auto& img = imgs[0];
+	tjhandle compressor = thread_compressor();
+
+	bool gray = std::is_same_v<T, ssimp::img::GRAY_8>;
+	TJSAMP subsampling =
+	    gray ? TJSAMP_GRAY
+	         : samp_from_string(
+	               std::get<std::string>(options.at("subsampling")));
+	int width = static_cast<int>(img.dims()[0]);
+	int height = static_cast<int>(img.dims()[1]);
+
+	if (std::get<bool>(options.at("parallel")))
+		return sink(encode_in_strips(
+		    reinterpret_cast<const unsigned char*>(img.span().data()), width,
+		    height, subsampling, std::get<int32_t>(options.at("quality")),
+		    std::get<int32_t>(options.at("strip_height")),
+		    std::get<int32_t>(options.at("threads"))));
+
+	// worst case size, so the compressor never needs to reallocate
+	unsigned long jpeg_size = tjBufSize(width, height, subsampling);
+	if (jpeg_size == static_cast<unsigned long>(-1))
+		throw ssimp::exceptions::IOError(std::format(
+		    "Jpeg compressor error: '{}'", tjGetErrorStr2(nullptr)));
+	CompressBuffer jpeg_buffer(jpeg_size);
+
+	if (tjCompress2(compressor,
+	                reinterpret_cast<const unsigned char*>(img.span().data()),
+	                width, 0, height, gray ? TJPF_GRAY : TJPF_RGB,
+	                &jpeg_buffer.data(), &jpeg_size,
+	                static_cast<int>(subsampling),
+	                std::get<int32_t>(options.at("quality")),
+	                jpeg_buffer.flags()))
+		throw ssimp::exceptions::IOError(std::format(
+		    "Jpeg compressor error: '{}'", tjGetErrorStr2(compressor)));
+
+	return sink(std::span<const std::byte>(
+	    reinterpret_cast<const std::byte*>(jpeg_buffer.data()), jpeg_size));
+}
 } // namespace
 
 namespace ssimp::formats {
 /* static */
-bool JPEG::image_count_supported(std::size_t count) { return count == 1; }
+bool JPEG::image_count_supported(std::size_t count) {
+	return count == 1 || count == 3;
+}
 
 /* static */
 bool JPEG::image_dims_supported(std::span<const std::size_t> dims) {
@@ -100,34 +733,67 @@ bool JPEG::image_dims_supported(std::span<const std::size_t> dims) {
 }
 
 /* static */ std::optional<std::vector<img::LocalizedImage>>
-JPEG::load_image(const fs::path& path, const option_types::options_t&) {
-	tjhandle decompressor = tjInitDecompress();
-	auto bytes = details::read_file(path);
+JPEG::load_image(const fs::path& path, const option_types::options_t& options) {
+	details::MappedFile file(path);
+	return load_image_from_memory(file.bytes(), options);
+}
+
+/* static */ std::optional<std::vector<img::LocalizedImage>>
+JPEG::load_image_from_memory(std::span<const std::byte> bytes,
+                             const option_types::options_t& options) {
+	tjhandle decompressor = thread_decompressor();
 
 	auto meta_data = jpeg_info(decompressor, bytes);
-	if (!meta_data) {
-		tjDestroy(decompressor);
+	if (!meta_data)
 		return {};
-	}
 
 	bool gray = meta_data->jpeg_colorspace == TJCS_GRAY;
 
 	TJPF pixel_format = gray ? TJPF_GRAY : TJPF_RGB;
 
+	tjscalingfactor factor =
+	    scaling_factor(std::get<double>(options.at("downscale")));
+	int width = TJSCALED(meta_data->width, factor);
+	int height = TJSCALED(meta_data->height, factor);
+
+	if (std::get<bool>(options.at("region"))) {
+		if (std::get<bool>(options.at("yuv_planes")))
+			throw exceptions::Unsupported(
+			    "Region can not be loaded as Y, Cb and Cr planes");
+
+		int x = std::get<int32_t>(options.at("region_x"));
+		int y = std::get<int32_t>(options.at("region_y"));
+		int region_width = std::get<int32_t>(options.at("region_width"));
+		int region_height = std::get<int32_t>(options.at("region_height"));
+		region_width = region_width == 0 ? width - x : region_width;
+		region_height = region_height == 0 ? height - y : region_height;
+
+		if (x >= width || y >= height || region_width <= 0 ||
+		    region_height <= 0 || int64_t(x) + region_width > width ||
+		    int64_t(y) + region_height > height)
+			throw exceptions::Unsupported(
+			    "Region is outside of the (downscaled) image");
+
+		return decode_region(bytes, factor, gray, x, y, region_width,
+		                     region_height);
+	}
+
+	if (std::get<bool>(options.at("yuv_planes")))
+		return decode_yuv_planes(decompressor, bytes, width, height,
+		                         meta_data->jpeg_subsampling);
+
 	img::ndImageBase dest_img = img::ndImage<img::GRAY_8>(1);
 	unsigned char* dest_ptr;
 	if (gray)
-		std::tie(dest_img, dest_ptr) =
-		    get_image<img::GRAY_8>(meta_data->width, meta_data->height);
+		std::tie(dest_img, dest_ptr) = get_image<img::GRAY_8>(width, height);
 	else
-		std::tie(dest_img, dest_ptr) =
-		    get_image<img::RGB_8>(meta_data->width, meta_data->height);
+		std::tie(dest_img, dest_ptr) = get_image<img::RGB_8>(width, height);
 
+	// the decoder chooses the scaling factor matching requested dimensions
 	int rv = tjDecompress2(decompressor,
 	                       reinterpret_cast<const unsigned char*>(bytes.data()),
-	                       bytes.size(), dest_ptr, meta_data->width, 0,
-	                       meta_data->height, pixel_format, 0);
-	tjDestroy(decompressor);
+	                       bytes.size(), dest_ptr, width, 0, height,
+	                       pixel_format, 0);
 	if (rv)
 		return {};
 
@@ -137,11 +803,10 @@ JPEG::load_image(const fs::path& path, const option_types::options_t&) {
 /* static */
 std::optional<ImageProperties>
 JPEG::get_information(const fs::path& path, const option_types::options_t&) {
-	tjhandle decompressor = tjInitDecompress();
-	auto bytes = details::read_file(path);
+	details::MappedFile file(path);
 
-	std::optional<JpegMeta> meta_data = jpeg_info(decompressor, bytes);
-	tjDestroy(decompressor);
+	std::optional<JpegMeta> meta_data =
+	    jpeg_info(thread_decompressor(), file.bytes());
 	if (!meta_data)
 		return {};
 
@@ -159,32 +824,75 @@ template <typename T>
 /* static */ void JPEG::save_image(const std::vector<img::ndImage<T>>& imgs,
                                    const fs::path& path,
                                    const option_types::options_t& options) {
-	auto& img = imgs[0];
-	tjhandle compressor = tjInitCompress();
+	encode(imgs, options, [&](std::span<const std::byte> bytes) {
+		details::save_file(path, bytes);
+	});
+}
 
-	unsigned char* jpeg_buffer = nullptr;
-	unsigned long jpeg_size;
+template <typename T>
+    requires mt::traits::is_any_of_tuple_v<T, JPEG::supported_types>
+/* static */ std::vector<std::byte>
+JPEG::encode_image(const std::vector<img::ndImage<T>>& imgs,
+                   const option_types::options_t& options) {
+	return encode(imgs, options, []<typename Bytes>(Bytes&& bytes) {
+		if constexpr (std::is_same_v<Bytes, std::vector<std::byte>>)
+			return std::move(bytes);
+		else
+			return std::vector<std::byte>(bytes.begin(), bytes.end());
+	});
+}
 
-	bool gray = std::is_same_v<T, img::GRAY_8>;
+/* static */ bool JPEG::transform_lossless(
+    const fs::path& input,
+    const fs::path& output,
+    const std::vector<option_types::options_t>& transforms) {
+	static const std::unordered_map<std::string, int> operations{
+	    {"none", TJXOP_NONE},
+	    {"rotate_90", TJXOP_ROT90},
+	    {"rotate_180", TJXOP_ROT180},
+	    {"rotate_270", TJXOP_ROT270},
+	    {"flip_horizontal", TJXOP_HFLIP},
+	    {"flip_vertical", TJXOP_VFLIP},
+	    {"transpose", TJXOP_TRANSPOSE},
+	    {"transverse", TJXOP_TRANSVERSE}};
 
-	if (tjCompress2(
-	        compressor,
-	        reinterpret_cast<const unsigned char*>(img.span().data()),
-	        img.dims()[0], 0, img.dims()[1], gray ? TJPF_GRAY : TJPF_RGB,
-	        &jpeg_buffer, &jpeg_size,
-	        static_cast<int>(gray ? TJSAMP_GRAY
-	                              : samp_from_string(std::get<std::string>(
-	                                    options.at("subsampling")))),
-	        std::get<int32_t>(options.at("quality")), 0)) {
-		std::cerr << "Jpeg compressor error\n";
-	}
+	tjhandle transformer = thread_transformer();
+	details::MappedFile file(input);
+	std::span<const std::byte> current = file.bytes();
+	tj_buffer_t result;
 
-	tjDestroy(compressor);
-	details::save_file(
-	    path, std::span<const std::byte>(
-	              reinterpret_cast<const std::byte*>(jpeg_buffer), jpeg_size));
+	for (const auto& options : transforms) {
+		tjtransform transform{};
+		transform.op =
+		    operations.at(std::get<std::string>(options.at("operation")));
+		// refuse to drop or distort partial MCUs on the edges
+		transform.options = TJXOPT_PERFECT;
+
+		if (std::get<bool>(options.at("crop"))) {
+			transform.options |= TJXOPT_CROP;
+			transform.r.x = std::get<int32_t>(options.at("crop_x"));
+			transform.r.y = std::get<int32_t>(options.at("crop_y"));
+			transform.r.w = std::get<int32_t>(options.at("crop_width"));
+			transform.r.h = std::get<int32_t>(options.at("crop_height"));
+		}
+
+		unsigned char* dest = nullptr;
+		unsigned long dest_size = 0;
+		int rv = tjTransform(
+		    transformer,
+		    reinterpret_cast<const unsigned char*>(current.data()),
+		    current.size(), 1, &dest, &dest_size, &transform, 0);
+		tj_buffer_t dest_owner(dest);
+		if (rv)
+			return false;
+
+		result = std::move(dest_owner);
+		current = {reinterpret_cast<const std::byte*>(result.get()),
+		           dest_size};
+	}
 
-	tjFree(jpeg_buffer);
+	details::save_file(output, current);
+	return true;
 }
 
 INSTANTIATE_SAVE_TEMPLATE(JPEG, img::GRAY_8);
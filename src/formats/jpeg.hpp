@@ -20,10 +20,33 @@ class JPEG {
 	load_image(const std::filesystem::path&,
 	           const option_types::options_t& options);
 
+	static std::optional<std::vector<img::LocalizedImage>>
+	load_image_from_memory(std::span<const std::byte> bytes,
+	                       const option_types::options_t& options);
+
 	template <typename T>
 	    requires mt::traits::is_any_of_tuple_v<T, JPEG::supported_types>
 	static void save_image(const std::vector<img::ndImage<T>>& imgs,
 	                       const std::filesystem::path& path,
 	                       const option_types::options_t& options);
+
+	template <typename T>
+	    requires mt::traits::is_any_of_tuple_v<T, JPEG::supported_types>
+	static std::vector<std::byte>
+	encode_image(const std::vector<img::ndImage<T>>& imgs,
+	             const option_types::options_t& options);
+
+	/**
+	 * Apply steps of 'transform' algorithm given by their **transforms**
+	 * options to image at **input** directly in DCT domain and save result to
+	 * **output**.
+	 *
+	 * Return false (and do not write anything) if any step can not be done
+	 * losslessly, e.g. the crop is not aligned to MCU.
+	 */
+	static bool
+	transform_lossless(const std::filesystem::path& input,
+	                   const std::filesystem::path& output,
+	                   const std::vector<option_types::options_t>& transforms);
 };
 } // namespace ssimp::formats
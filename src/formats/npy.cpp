@@ -0,0 +1,390 @@
+#include "npy.hpp"
+#include "common_macro.hpp"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <charconv>
+#include <format>
+#include <numeric>
+#include <string_view>
+
+namespace {
+using ssimp::img::elem_type;
+
+/**
+ * NumPy description of the samples of each element type (without the byte
+ * order character) together with the number of samples per element and
+ * names of their fields.
+ */
+struct TypeDescription {
+	elem_type type;
+	std::string_view kind;
+	std::size_t channels;
+	std::string_view fields;
+};
+
+constexpr std::array type_descriptions{
+    TypeDescription{elem_type::GRAY_8, "u1", 1, ""},
+    TypeDescription{elem_type::GRAYA_8, "u1", 2, "ya"},
+    TypeDescription{elem_type::GRAY_16, "u2", 1, ""},
+    TypeDescription{elem_type::GRAY_32, "u4", 1, ""},
+    TypeDescription{elem_type::GRAY_64, "u8", 1, ""},
+    TypeDescription{elem_type::FLOAT, "f4", 1, ""},
+    TypeDescription{elem_type::DOUBLE, "f8", 1, ""},
+    TypeDescription{elem_type::RGB_8, "u1", 3, "rgb"},
+    TypeDescription{elem_type::RGBA_8, "u1", 4, "rgba"},
+    TypeDescription{elem_type::COMPLEX_F, "c8", 1, ""},
+    TypeDescription{elem_type::COMPLEX_D, "c16", 1, ""}};
+
+constexpr std::string_view magic = "\x93NUMPY";
+constexpr char native_order =
+    std::endian::native == std::endian::little ? '<' : '>';
+
+/**
+ * Parsed header of the array.
+ */
+struct Header {
+	elem_type type;
+	std::vector<std::size_t> dims;
+	std::size_t sample_size;
+	bool swap_bytes;
+	std::size_t data_offset;
+};
+
+/**
+ * Return value of **key** in the python dictionary **dict**, that is
+ * everything between the colon after the key and the next comma outside of
+ * parentheses.
+ */
+std::optional<std::string_view> dict_value(std::string_view dict,
+                                           std::string_view key) {
+	std::size_t pos = dict.find(key);
+	if (pos == dict.npos)
+		return {};
+	pos = dict.find(':', pos + key.size());
+	if (pos == dict.npos)
+		return {};
+
+	std::size_t end = pos + 1;
+	for (int depth = 0; end < dict.size(); ++end) {
+		if (dict[end] == '(' || dict[end] == '[')
+			++depth;
+		else if (dict[end] == ')' || dict[end] == ']')
+			--depth;
+		else if ((dict[end] == ',' && depth == 0) || dict[end] == '}')
+			break;
+	}
+
+	std::string_view value = dict.substr(pos + 1, end - pos - 1);
+	std::size_t first = value.find_first_not_of(" ");
+	std::size_t last = value.find_last_not_of(" ");
+	if (first == value.npos)
+		return {};
+	return value.substr(first, last - first + 1);
+}
+
+/**
+ * Number of fields of structured array description **descr** if all of them
+ * are bytes, e.g. [('r', '|u1'), ('g', '|u1'), ('b', '|u1')], zero otherwise.
+ */
+std::size_t byte_fields(std::string_view descr) {
+	if (!descr.starts_with('[') || !descr.ends_with(']'))
+		return 0;
+
+	std::size_t count = 0;
+	for (std::size_t pos = descr.find('('); pos != descr.npos;
+	     pos = descr.find('(', pos + 1)) {
+		std::size_t end = descr.find(')', pos);
+		if (end == descr.npos)
+			return 0;
+		std::string_view field = descr.substr(pos, end - pos);
+		if (!field.ends_with("'|u1'") && !field.ends_with("'u1'"))
+			return 0;
+		++count;
+	}
+	return count;
+}
+
+/**
+ * Parse the header of .npy file in **bytes**, return nothing if it is not a
+ * valid header or the array can not be represented by an image. Byte arrays
+ * with the fastest changing axis of 2, 3 or 4 are read as channels only if
+ * **last_axis_channels** is set, structured arrays of byte fields always.
+ */
+std::optional<Header> parse_header(std::span<const std::byte> bytes,
+                                   bool last_axis_channels) {
+	std::string_view text(reinterpret_cast<const char*>(bytes.data()),
+	                      bytes.size());
+	if (!text.starts_with(magic) || text.size() < 10)
+		return {};
+
+	// version 1.0 has 16-bit header length, later versions 32-bit one
+	std::uint8_t major = std::uint8_t(text[6]);
+	std::size_t length_size = major == 1 ? 2 : 4;
+	if (text.size() < 8 + length_size)
+		return {};
+	std::size_t header_length = 0;
+	for (std::size_t i = 0; i < length_size; ++i)
+		header_length |= std::size_t(std::uint8_t(text[8 + i])) << (8 * i);
+
+	Header header{};
+	header.data_offset = 8 + length_size + header_length;
+	if (text.size() < header.data_offset)
+		return {};
+	std::string_view dict = text.substr(8 + length_size, header_length);
+
+	auto descr = dict_value(dict, "'descr'");
+	auto fortran_order = dict_value(dict, "'fortran_order'");
+	auto shape = dict_value(dict, "'shape'");
+	if (!descr || !fortran_order || !shape || descr->size() < 4 ||
+	    shape->size() < 2)
+		return {};
+
+	// descr is quoted, e.g. '<f8', or lists fields of structured array
+	std::size_t fields = byte_fields(*descr);
+	char order = fields > 0 ? '|' : (*descr)[1];
+	std::string_view kind =
+	    fields > 0 ? "u1" : descr->substr(2, descr->size() - 3);
+
+	std::vector<std::size_t> axes;
+	std::string_view numbers = shape->substr(1, shape->size() - 2);
+	while (!numbers.empty()) {
+		std::size_t pos = numbers.find_first_not_of(" ,");
+		if (pos == numbers.npos)
+			break;
+		numbers.remove_prefix(pos);
+
+		std::size_t axis = 0;
+		auto [ptr, ec] = std::from_chars(
+		    numbers.data(), numbers.data() + numbers.size(), axis);
+		if (ec != std::errc())
+			return {};
+		axes.push_back(axis);
+		numbers.remove_prefix(std::size_t(ptr - numbers.data()));
+	}
+	if (axes.empty())
+		return {};
+
+	// image dimensions go from the fastest changing axis
+	if (*fortran_order != "True")
+		std::ranges::reverse(axes);
+
+	std::size_t channels = fields > 0 ? fields : 1;
+	if (fields == 0 && last_axis_channels && kind == "u1" &&
+	    axes.size() >= 2 && axes[0] >= 2 && axes[0] <= 4) {
+		channels = axes[0];
+		axes.erase(axes.begin());
+	}
+
+	auto description = std::ranges::find_if(
+	    type_descriptions, [&](const TypeDescription& desc) {
+		    return desc.kind == kind && desc.channels == channels;
+	    });
+	if (description == type_descriptions.end())
+		return {};
+
+	std::size_t sample_size = 0;
+	std::from_chars(kind.data() + 1, kind.data() + kind.size(), sample_size);
+	if (sample_size > 1 && order != '<' && order != '>' && order != '=')
+		return {};
+
+	header.type = description->type;
+	header.dims = std::move(axes);
+	header.sample_size = description->kind == "c8"    ? 4
+	                     : description->kind == "c16" ? 8
+	                                                  : sample_size;
+	header.swap_bytes =
+	    header.sample_size > 1 && order != '=' && order != native_order;
+	return header;
+}
+
+/**
+ * Create image of type **T** from the data following **header**. If
+ * **owner** is given and the data need no conversion, the image refers
+ * directly to **data**. Otherwise, the data are copied.
+ */
+template <typename T>
+std::optional<ssimp::img::ndImageBase>
+create_image(const Header& header,
+             std::span<std::byte> data,
+             std::shared_ptr<void> owner) {
+	std::size_t count = std::reduce(header.dims.begin(), header.dims.end(),
+	                                std::size_t(1), std::multiplies{});
+	if (data.size() < count * sizeof(T))
+		return {};
+	data = data.first(count * sizeof(T));
+
+	bool aligned = std::uintptr_t(data.data()) % alignof(T) == 0;
+	if (owner && aligned && !header.swap_bytes)
+		return ssimp::img::ndImage<T>(
+		    header.dims, std::move(owner),
+		    std::span(reinterpret_cast<T*>(data.data()), count));
+
+	ssimp::img::ndImage<T> out(header.dims);
+	auto out_bytes = std::as_writable_bytes(out.span());
+	std::ranges::copy(data, out_bytes.begin());
+	if (header.swap_bytes)
+		for (std::size_t i = 0; i < out_bytes.size(); i += header.sample_size)
+			std::reverse(out_bytes.begin() + i,
+			             out_bytes.begin() + i + header.sample_size);
+	return out;
+}
+
+/**
+ * Create image of the type given by **header**, see **create_image**.
+ */
+template <typename... types_t>
+std::optional<std::vector<ssimp::img::LocalizedImage>>
+create_any_image(std::tuple<types_t...>*,
+                 const Header& header,
+                 std::span<std::byte> data,
+                 std::shared_ptr<void> owner) {
+	std::optional<ssimp::img::ndImageBase> out;
+	((header.type == ssimp::img::type_to_enum<types_t>
+	      ? (out = create_image<types_t>(header, data, owner), 0)
+	      : 0),
+	 ...);
+
+	if (!out)
+		return {};
+	return std::vector<ssimp::img::LocalizedImage>{{*out}};
+}
+
+/**
+ * Load array from **data**, see **create_image**.
+ */
+std::optional<std::vector<ssimp::img::LocalizedImage>>
+load_array(std::span<std::byte> data,
+           std::shared_ptr<void> owner,
+           const ssimp::option_types::options_t& options) {
+	std::optional<Header> header =
+	    parse_header(data, std::get<bool>(options.at("channels")));
+	if (!header)
+		return {};
+
+	return create_any_image(
+	    static_cast<ssimp::img::type_list*>(nullptr), *header,
+	    data.subspan(header->data_offset), std::move(owner));
+}
+
+/**
+ * Create header for array of **dims** of type **T**, padded so the data
+ * start at a multiple of 64 bytes. Channels are fields of structured array.
+ */
+template <typename T>
+std::vector<std::byte> create_header(std::span<const std::size_t> dims) {
+	const TypeDescription& description = *std::ranges::find(
+	    type_descriptions, ssimp::img::type_to_enum<T>, &TypeDescription::type);
+
+	char order = description.kind == "u1" ? '|' : native_order;
+	std::string descr = std::format("'{}{}'", order, description.kind);
+	if (description.channels > 1) {
+		descr = "[";
+		for (char field : description.fields)
+			descr += std::format("('{}', '|u1'), ", field);
+		descr.resize(descr.size() - 2);
+		descr += "]";
+	}
+
+	std::string shape;
+	for (std::size_t dim : dims)
+		shape = std::format("{}, ", dim) + shape;
+	if (dims.size() > 1)
+		shape.resize(shape.size() - 2);
+	else
+		shape.pop_back();
+
+	std::string dict = std::format(
+	    "{{'descr': {}, 'fortran_order': False, 'shape': ({}), }}", descr,
+	    shape);
+
+	std::size_t length_size = dict.size() + 11 < 65536 ? 2 : 4;
+	std::size_t unpadded = magic.size() + 2 + length_size + dict.size() + 1;
+	dict.append((64 - unpadded % 64) % 64, ' ');
+	dict.push_back('\n');
+
+	std::string out(magic);
+	out.push_back(char(length_size == 2 ? 1 : 2));
+	out.push_back(0);
+	for (std::size_t i = 0; i < length_size; ++i)
+		out.push_back(char((dict.size() >> (8 * i)) & 0xff));
+	out += dict;
+
+	auto bytes = std::as_bytes(std::span(out));
+	return {bytes.begin(), bytes.end()};
+}
+} // namespace
+
+namespace ssimp::formats {
+/* static */ bool NPY::image_count_supported(std::size_t count) {
+	return count == 1;
+}
+
+/* static */ bool NPY::image_dims_supported(std::span<const std::size_t> dims) {
+	return !dims.empty();
+}
+
+/* static */ std::optional<ImageProperties>
+NPY::get_information(const std::filesystem::path& path,
+                     const option_types::options_t& options) {
+	details::MappedFile file(path);
+	std::optional<Header> header =
+	    parse_header(file.bytes(), std::get<bool>(options.at("channels")));
+	if (!header)
+		return {};
+
+	ImageProperties props{name, header->dims};
+	props.others["Element type"] = to_string(header->type);
+	return props;
+}
+
+/* static */ std::optional<std::vector<img::LocalizedImage>>
+NPY::load_image(const std::filesystem::path& path,
+                const option_types::options_t& options) {
+	auto file = std::make_shared<details::MappedFile>(path, true);
+	return load_array(file->writable_bytes(), file, options);
+}
+
+/* static */ std::optional<std::vector<img::LocalizedImage>>
+NPY::load_image_from_memory(std::span<const std::byte> bytes,
+                            const option_types::options_t& options) {
+	// without an owner the data are only read from and copied
+	return load_array({const_cast<std::byte*>(bytes.data()), bytes.size()},
+	                  nullptr, options);
+}
+
+template <typename T>
+    requires mt::traits::is_any_of_tuple_v<T, NPY::supported_types>
+/* static */ void NPY::save_image(const std::vector<img::ndImage<T>>& imgs,
+                                  const std::filesystem::path& path,
+                                  const option_types::options_t& options) {
+	std::vector<std::byte> header = create_header<T>(imgs[0].dims());
+	std::array<std::span<const std::byte>, 2> parts{
+	    header, std::as_bytes(imgs[0].span())};
+	details::save_file(path, parts);
+}
+
+template <typename T>
+    requires mt::traits::is_any_of_tuple_v<T, NPY::supported_types>
+/* static */ std::vector<std::byte>
+NPY::encode_image(const std::vector<img::ndImage<T>>& imgs,
+                  const option_types::options_t& options) {
+	std::vector<std::byte> out = create_header<T>(imgs[0].dims());
+	auto data = std::as_bytes(imgs[0].span());
+	out.insert(out.end(), data.begin(), data.end());
+	return out;
+}
+
+INSTANTIATE_SAVE_TEMPLATE(NPY, img::GRAY_8);
+INSTANTIATE_SAVE_TEMPLATE(NPY, img::GRAYA_8);
+INSTANTIATE_SAVE_TEMPLATE(NPY, img::GRAY_16);
+INSTANTIATE_SAVE_TEMPLATE(NPY, img::GRAY_32);
+INSTANTIATE_SAVE_TEMPLATE(NPY, img::GRAY_64);
+INSTANTIATE_SAVE_TEMPLATE(NPY, img::FLOAT);
+INSTANTIATE_SAVE_TEMPLATE(NPY, img::DOUBLE);
+INSTANTIATE_SAVE_TEMPLATE(NPY, img::RGB_8);
+INSTANTIATE_SAVE_TEMPLATE(NPY, img::RGBA_8);
+INSTANTIATE_SAVE_TEMPLATE(NPY, img::COMPLEX_F);
+INSTANTIATE_SAVE_TEMPLATE(NPY, img::COMPLEX_D);
+
+} // namespace ssimp::formats
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "common.hpp"
+
+namespace ssimp::formats {
+/**
+ * NumPy .npy arrays. Every element type and any number of dimensions can be
+ * stored, so the format serves as a lossless cache between pipeline runs.
+ *
+ * The first image dimension is the fastest changing one, so it is the last
+ * axis of the (C order) array, e.g. 2D image of (width, height) is stored as
+ * an array of shape (height, width). Elements of GRAYA_8, RGB_8 and RGBA_8
+ * are structured with one byte field per channel. Plain byte arrays with the
+ * last axis of 2, 3 or 4 are loaded as channels only on request.
+ */
+class NPY {
+  public:
+	using supported_types = img::type_list;
+	constexpr static const char* name = "npy";
+
+	static bool image_count_supported(std::size_t count);
+	static bool image_dims_supported(std::span<const std::size_t> dims);
+	static constexpr bool same_dims_required() { return true; }
+
+	static std::optional<ImageProperties>
+	get_information(const std::filesystem::path& path,
+	                const option_types::options_t& options);
+
+	/**
+	 * The file is memory mapped copy-on-write and the image points directly
+	 * into the mapping, so nothing is read until the data are accessed.
+	 */
+	static std::optional<std::vector<img::LocalizedImage>>
+	load_image(const std::filesystem::path&,
+	           const option_types::options_t& options);
+
+	static std::optional<std::vector<img::LocalizedImage>>
+	load_image_from_memory(std::span<const std::byte> bytes,
+	                       const option_types::options_t& options);
+
+	template <typename T>
+	    requires mt::traits::is_any_of_tuple_v<T, NPY::supported_types>
+	static void save_image(const std::vector<img::ndImage<T>>& imgs,
+	                       const std::filesystem::path& path,
+	                       const option_types::options_t& options);
+
+	template <typename T>
+	    requires mt::traits::is_any_of_tuple_v<T, NPY::supported_types>
+	static std::vector<std::byte>
+	encode_image(const std::vector<img::ndImage<T>>& imgs,
+	             const option_types::options_t& options);
+};
+} // namespace ssimp::formats
@@ -1,5 +1,11 @@
 #include "png.hpp"
 #include "common_macro.hpp"
+#include "../application/parallel.hpp"
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
 #include <map>
 #include <png.h>
 #include <zlib.h>
@@ -51,32 +57,15 @@ png_uint_32 string_to_format(const std::string& format) {
 	throw ssimp::exceptions::Unsupported(
 	    std::format("Format {} is not supported", format));
 }
-} // namespace
-
-namespace ssimp::formats {
-
-/* static */ bool PNG::image_count_supported(std::size_t count) {
-	return count == 1;
-}
-
-/* static */ bool PNG::image_dims_supported(std::span<const std::size_t> dims) {
-	return dims.size() == 2 && dims[0] > 0 && dims[1] > 0;
-}
-
-/* static */ std::optional<std::vector<img::LocalizedImage>>
-PNG::load_image(const std::filesystem::path& path,
-                const option_types::options_t& options) {
-	std::string str_path = path.string();
-
-	png_image image;
-	std::memset(&image, 0, sizeof(png_image));
-	image.version = PNG_IMAGE_VERSION;
-
-	if (!png_image_begin_read_from_file(&image, str_path.c_str()))
-		return {};
 
+/**
+ * Decode the image whose reading has already begun (either from file or from
+ * memory).
+ */
+std::optional<std::vector<ssimp::img::LocalizedImage>>
+finish_loading(png_image& image) {
 	png_bytep buffer = nullptr;
-	std::vector<img::LocalizedImage> out;
+	std::vector<ssimp::img::LocalizedImage> out;
 
 	png_uint_32 mem_format;
 	switch (image.format) {
@@ -114,35 +103,961 @@ PNG::load_image(const std::filesystem::path& path,
 
 	std::array dims{std::size_t(image.width), std::size_t(image.height)};
 	if (mem_format == PNG_FORMAT_RGBA) {
-		img::ndImage<img::RGBA_8> typed_img(dims);
+		ssimp::img::ndImage<ssimp::img::RGBA_8> typed_img(dims);
 		out.emplace_back(typed_img);
 		buffer = reinterpret_cast<png_bytep>(typed_img.span().data());
 	} else if (mem_format == PNG_FORMAT_RGB) {
-		img::ndImage<img::RGB_8> typed_img(dims);
+		ssimp::img::ndImage<ssimp::img::RGB_8> typed_img(dims);
 		out.emplace_back(typed_img);
 		buffer = reinterpret_cast<png_bytep>(typed_img.span().data());
 	} else if (mem_format == PNG_FORMAT_GRAY) {
-		img::ndImage<img::GRAY_8> typed_img(dims);
+		ssimp::img::ndImage<ssimp::img::GRAY_8> typed_img(dims);
 		out.emplace_back(typed_img);
 		buffer = reinterpret_cast<png_bytep>(typed_img.span().data());
 	} else if (mem_format == PNG_FORMAT_GA) {
-		img::ndImage<img::GRAYA_8> typed_img(dims);
+		ssimp::img::ndImage<ssimp::img::GRAYA_8> typed_img(dims);
 		out.emplace_back(typed_img);
 		buffer = reinterpret_cast<png_bytep>(typed_img.span().data());
 	}
 	assert(buffer != nullptr);
 
-	png_image_finish_read(&image, nullptr, buffer, 0, nullptr);
+	image.format = mem_format;
+	if (!png_image_finish_read(&image, nullptr, buffer, 0, nullptr))
+		return {};
 
 	return out;
 }
 
+/**
+ * Number of channels and bits per sample of PNG images of element type **T**.
+ */
+template <typename T>
+constexpr std::size_t channel_count =
+    std::is_same_v<T, ssimp::img::GRAY_16> ? 1 : sizeof(T);
+
+template <typename T>
+constexpr std::size_t bit_depth = sizeof(T) / channel_count<T> * 8;
+
+/**
+ * Check that the requested **colorspace** keeps the channel count of **T**.
+ */
+template <typename T>
+void check_colorspace(const std::string& colorspace) {
+	if (colorspace == "auto")
+		return;
+
+	if constexpr (bit_depth<T> != 8)
+		throw ssimp::exceptions::Unsupported(
+		    "Colorspace conversion is supported only for 8-bit images");
+
+	std::size_t requested =
+	    PNG_IMAGE_SAMPLE_CHANNELS(string_to_format(colorspace));
+	if (requested != channel_count<T>)
+		throw ssimp::exceptions::Unsupported(std::format(
+		    "Cannot convert images to different channel size, got: {}, "
+		    "requested: {}",
+		    channel_count<T>, requested));
+}
+
+/**
+ * Table converting 8-bit samples to 16-bit linear ones. The same gamma is
+ * used as libpng uses for 8-bit sRGB files (pure power of 1 / 0.45455).
+ */
+const std::array<std::uint16_t, 256>& linear_table() {
+	static const std::array<std::uint16_t, 256> table = [] {
+		std::array<std::uint16_t, 256> out;
+		for (std::size_t i = 0; i < out.size(); ++i)
+			out[i] = std::uint16_t(std::lround(
+			    std::pow(double(i) / 255.0, 1.0 / 0.45455) * 65535.0));
+		return out;
+	}();
+	return table;
+}
+
+/**
+ * State shared by libpng callbacks of the row reader and writer.
+ */
+struct StreamState {
+	png_structp png = nullptr;
+	png_infop info = nullptr;
+	std::string error;
+
+	std::istream* input = nullptr;
+	std::span<const std::byte> input_memory;
+	std::size_t input_position = 0;
+
+	std::ostream* output = nullptr;
+	std::vector<std::byte>* output_memory = nullptr;
+};
+
+void error_fn(png_structp png, png_const_charp message) {
+	static_cast<StreamState*>(png_get_error_ptr(png))->error = message;
+	png_longjmp(png, 1);
+}
+
+void warning_fn(png_structp, png_const_charp) {}
+
+void read_fn(png_structp png, png_bytep data, std::size_t length) {
+	auto& state = *static_cast<StreamState*>(png_get_io_ptr(png));
+
+	if (state.input) {
+		state.input->read(reinterpret_cast<char*>(data),
+		                  static_cast<std::streamsize>(length));
+		if (std::size_t(state.input->gcount()) != length)
+			png_error(png, "Unexpected end of file");
+		return;
+	}
+
+	if (state.input_memory.size() - state.input_position < length)
+		png_error(png, "Unexpected end of data");
+	std::memcpy(data, state.input_memory.data() + state.input_position,
+	            length);
+	state.input_position += length;
+}
+
+/**
+ * Append **bytes** to the output of **state**, return false on failure.
+ */
+bool write_raw(StreamState& state, std::span<const std::byte> bytes) {
+	if (state.output) {
+		state.output->write(reinterpret_cast<const char*>(bytes.data()),
+		                    static_cast<std::streamsize>(bytes.size()));
+		return bool(*state.output);
+	}
+
+	state.output_memory->insert(state.output_memory->end(), bytes.begin(),
+	                            bytes.end());
+	return true;
+}
+
+void write_fn(png_structp png, png_bytep data, std::size_t length) {
+	auto& state = *static_cast<StreamState*>(png_get_io_ptr(png));
+	if (!write_raw(state, {reinterpret_cast<const std::byte*>(data), length}))
+		png_error(png, "Could not write the output");
+}
+
+void flush_fn(png_structp png) {
+	auto& state = *static_cast<StreamState*>(png_get_io_ptr(png));
+	if (state.output)
+		state.output->flush();
+}
+
+void init_reader(StreamState& state) {
+	state.png = png_create_read_struct(PNG_LIBPNG_VER_STRING, &state,
+	                                   error_fn, warning_fn);
+	if (state.png)
+		state.info = png_create_info_struct(state.png);
+	if (!state.info)
+		throw std::bad_alloc();
+	png_set_read_fn(state.png, &state, read_fn);
+}
+
+void init_writer(StreamState& state) {
+	state.png = png_create_write_struct(PNG_LIBPNG_VER_STRING, &state,
+	                                    error_fn, warning_fn);
+	if (state.png)
+		state.info = png_create_info_struct(state.png);
+	if (!state.info)
+		throw std::bad_alloc();
+	png_set_write_fn(state.png, &state, write_fn, flush_fn);
+}
+
+/**
+ * Mask of all filter types, bit i stands for the filter of type i.
+ */
+constexpr std::uint8_t all_filters = 0x1f;
+
+const std::unordered_map<std::string, std::uint8_t> filter_masks{
+    {"adaptive", all_filters}, {"none", 1},     {"sub", 2},
+    {"up", 4},                 {"average", 8},  {"paeth", 16},
+    {"auto", all_filters}};
+
+const std::unordered_map<std::string, int> zlib_strategies{
+    {"filtered", Z_FILTERED},
+    {"default", Z_DEFAULT_STRATEGY},
+    {"rle", Z_RLE},
+    {"huffman_only", Z_HUFFMAN_ONLY},
+    {"auto", Z_FILTERED}};
+
+/**
+ * Callback state of the row writer together with the image description.
+ */
+struct WriterState : StreamState {
+	png_uint_32 width = 0;
+	png_uint_32 height = 0;
+	std::size_t channels = 0;
+	int bit_depth = 8;
+	bool linear = false;
+	bool header_written = false;
+
+	int level = Z_DEFAULT_COMPRESSION;
+	int strategy = Z_FILTERED;
+	std::uint8_t filters = all_filters;
+	bool auto_strategy = false;
+	bool auto_filters = false;
+
+	bool parallel = false;
+	std::size_t block_size = 0;
+	std::size_t threads = 0;
+};
+
+/**
+ * Fill **state** of the row writer and create the libpng structures.
+ */
+void setup_writer(WriterState& state,
+                  std::size_t width,
+                  std::size_t height,
+                  std::size_t channels,
+                  std::size_t bit_depth,
+                  const ssimp::option_types::options_t& options) {
+	if (channels < 1 || channels > 4)
+		throw ssimp::exceptions::Unsupported(
+		    std::format("Unsupported channel count: {}", channels));
+	if (bit_depth != 8 && bit_depth != 16)
+		throw ssimp::exceptions::Unsupported(
+		    std::format("Unsupported bit depth: {}", bit_depth));
+
+	state.width = png_uint_32(width);
+	state.height = png_uint_32(height);
+	state.channels = channels;
+	if (std::get<bool>(options.at("fast_save"))) {
+		// unfiltered rows at level 3, libpng defaults to the default
+		// strategy for them
+		state.level = 3;
+		state.filters = filter_masks.at("none");
+		state.strategy = Z_DEFAULT_STRATEGY;
+	} else {
+		std::string filter = std::get<std::string>(options.at("filter"));
+		std::string strategy = std::get<std::string>(options.at("strategy"));
+		state.level = std::get<int32_t>(options.at("compression_level"));
+		state.filters = filter_masks.at(filter);
+		state.strategy = zlib_strategies.at(strategy);
+		state.auto_filters = filter == "auto";
+		state.auto_strategy = strategy == "auto";
+	}
+
+	state.linear = std::get<std::string>(options.at("colorspace"))
+	                   .starts_with("Linear ");
+	state.bit_depth = state.linear ? 16 : int(bit_depth);
+	state.parallel = std::get<bool>(options.at("parallel"));
+	if (state.parallel) {
+		state.block_size =
+		    std::size_t(std::get<int32_t>(options.at("block_size"))) * 1024;
+		state.threads = std::size_t(std::get<int32_t>(options.at("threads")));
+	}
+	init_writer(state);
+}
+
+/**
+ * Write the header, called by the writer just before the first row.
+ */
+void write_header(WriterState& state) {
+	constexpr std::array color_types{PNG_COLOR_TYPE_GRAY,
+	                                 PNG_COLOR_TYPE_GRAY_ALPHA,
+	                                 PNG_COLOR_TYPE_RGB, PNG_COLOR_TYPE_RGBA};
+
+	png_set_IHDR(state.png, state.info, state.width, state.height,
+	             state.bit_depth, color_types[state.channels - 1],
+	             PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT,
+	             PNG_FILTER_TYPE_DEFAULT);
+
+	// same chunks as the simplified API writes
+	if (state.linear) {
+		png_set_gAMA_fixed(state.png, state.info, PNG_GAMMA_LINEAR);
+		png_set_cHRM_fixed(state.png, state.info, 31270, 32900, 64000, 33000,
+		                   30000, 60000, 15000, 6000);
+	} else
+		png_set_sRGB(state.png, state.info, PNG_sRGB_INTENT_PERCEPTUAL);
+
+	// libpng masks have the filter of type 0 at bit 3
+	png_set_filter(state.png, PNG_FILTER_TYPE_BASE, state.filters << 3);
+	png_set_compression_level(state.png, state.level);
+	png_set_compression_strategy(state.png, state.strategy);
+
+	png_write_info(state.png, state.info);
+
+	// takes effect only after the bit depth is written
+	if (state.bit_depth == 16 && std::endian::native == std::endian::little)
+		png_set_swap(state.png);
+}
+
+/**
+ * Filter **row** into **out** (prefixed by the filter type) using the filter
+ * from the mask **filters** with the least sum of absolute differences, the
+ * same heuristic libpng uses. **prev** is the previous row, zeros for the
+ * first one.
+ */
+void filter_row(std::span<const std::uint8_t> row,
+                std::span<const std::uint8_t> prev,
+                std::size_t bpp,
+                std::uint8_t filters,
+                std::span<std::uint8_t> out,
+                std::vector<std::uint8_t>& candidate) {
+	candidate.resize(row.size());
+	std::size_t best_sum = std::numeric_limits<std::size_t>::max();
+
+	auto try_filter = [&](std::uint8_t type, auto predict) {
+		if (!(filters & (1 << type)))
+			return;
+
+		std::size_t sum = 0;
+		for (std::size_t i = 0; i < bpp && i < row.size(); ++i) {
+			candidate[i] = std::uint8_t(row[i] - predict(0, prev[i], 0));
+			sum += candidate[i] < 128 ? candidate[i] : 256 - candidate[i];
+		}
+		for (std::size_t i = bpp; i < row.size() && sum < best_sum; ++i) {
+			candidate[i] = std::uint8_t(
+			    row[i] - predict(row[i - bpp], prev[i], prev[i - bpp]));
+			sum += candidate[i] < 128 ? candidate[i] : 256 - candidate[i];
+		}
+
+		if (sum < best_sum) {
+			best_sum = sum;
+			out[0] = type;
+			std::ranges::copy(candidate, out.begin() + 1);
+		}
+	};
+
+	try_filter(0, [](int, int, int) { return 0; });
+	try_filter(1, [](int a, int, int) { return a; });
+	try_filter(2, [](int, int b, int) { return b; });
+	try_filter(3, [](int a, int b, int) { return (a + b) / 2; });
+	try_filter(4, [](int a, int b, int c) {
+		int p = a + b - c;
+		int pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+		if (pa <= pb && pa <= pc)
+			return a;
+		return pb <= pc ? b : c;
+	});
+}
+
+/**
+ * Filter **count** rows of **samples** starting at **first** into **out**.
+ */
+void filter_rows(std::span<const std::byte> samples,
+                 std::size_t row_size,
+                 std::size_t bpp,
+                 std::uint8_t filters,
+                 std::size_t first,
+                 std::size_t count,
+                 std::span<std::byte> out) {
+	auto in = reinterpret_cast<const std::uint8_t*>(samples.data());
+	auto filtered = reinterpret_cast<std::uint8_t*>(out.data());
+	std::vector<std::uint8_t> candidate;
+	std::vector<std::uint8_t> zeros(row_size);
+
+	for (std::size_t y = first; y < first + count; ++y) {
+		std::span<const std::uint8_t> row(in + y * row_size, row_size);
+		std::span<const std::uint8_t> prev = zeros;
+		if (y > 0)
+			prev = {in + (y - 1) * row_size, row_size};
+		std::span<std::uint8_t> filtered_row(
+		    filtered + (y - first) * (row_size + 1), row_size + 1);
+		filter_row(row, prev, bpp, filters, filtered_row, candidate);
+	}
+}
+
+struct DeflateEnd {
+	void operator()(z_stream* stream) const { deflateEnd(stream); }
+};
+
+/**
+ * Raw deflate stream of one block together with the checksum of its input.
+ */
+struct DeflatedBlock {
+	std::vector<std::byte> data;
+	uLong adler;
+};
+
+/**
+ * Compress **block** as a part of a longer raw deflate stream. The stream is
+ * primed with **dictionary** (the end of the preceding block) and ends with a
+ * sync flush, unless it is the **last** one.
+ */
+DeflatedBlock deflate_block(std::span<const std::byte> block,
+                            std::span<const std::byte> dictionary,
+                            bool last,
+                            int level,
+                            int strategy) {
+	auto in = reinterpret_cast<const Bytef*>(block.data());
+	DeflatedBlock out{
+	    {}, adler32(adler32(0, nullptr, 0), in, uInt(block.size()))};
+
+	z_stream stream{};
+	if (deflateInit2(&stream, level, Z_DEFLATED, -15, 8, strategy) != Z_OK)
+		throw ssimp::exceptions::IOError("Could not initialize zlib");
+	std::unique_ptr<z_stream, DeflateEnd> guard(&stream);
+
+	if (!dictionary.empty())
+		deflateSetDictionary(&stream,
+		                     reinterpret_cast<const Bytef*>(dictionary.data()),
+		                     uInt(dictionary.size()));
+
+	out.data.resize(deflateBound(&stream, uLong(block.size())) + 64);
+	stream.next_in = const_cast<Bytef*>(in);
+	stream.avail_in = uInt(block.size());
+	stream.next_out = reinterpret_cast<Bytef*>(out.data.data());
+	stream.avail_out = uInt(out.data.size());
+
+	while (true) {
+		int ret = deflate(&stream, last ? Z_FINISH : Z_SYNC_FLUSH);
+		if (ret == Z_STREAM_ERROR)
+			throw ssimp::exceptions::IOError("Deflate failed");
+		if (last ? ret == Z_STREAM_END : stream.avail_out != 0)
+			break;
+
+		std::size_t written = out.data.size();
+		out.data.resize(written * 2);
+		stream.next_out = reinterpret_cast<Bytef*>(out.data.data() + written);
+		stream.avail_out = uInt(out.data.size() - written);
+	}
+
+	out.data.resize(stream.total_out);
+	return out;
+}
+
+/**
+ * Write chunk of **type** whose data are the concatenation of **parts**.
+ */
+void write_chunk(StreamState& state,
+                 const char (&type)[5],
+                 std::initializer_list<std::span<const std::byte>> parts) {
+	auto big_endian = [](std::uint32_t value) {
+		return std::array{std::byte(value >> 24), std::byte(value >> 16),
+		                  std::byte(value >> 8), std::byte(value)};
+	};
+
+	std::uint32_t length = 0;
+	uLong crc = crc32(0, reinterpret_cast<const Bytef*>(type), 4);
+	for (auto part : parts) {
+		// crc32 with null data would return the initial value
+		if (part.empty())
+			continue;
+		length += std::uint32_t(part.size());
+		crc = crc32(crc, reinterpret_cast<const Bytef*>(part.data()),
+		            uInt(part.size()));
+	}
+
+	bool ok = write_raw(state, big_endian(length)) &&
+	          write_raw(state, std::as_bytes(std::span(type, 4)));
+	for (auto part : parts)
+		ok = ok && write_raw(state, part);
+	if (!ok || !write_raw(state, big_endian(std::uint32_t(crc))))
+		throw ssimp::exceptions::IOError("Could not write the output");
+}
+
+/**
+ * Filter and compress **rows** (in the byte order of the file) in parallel
+ * and write them as IDAT chunks followed by IEND. The header has to be
+ * already written.
+ *
+ * Rows are filtered concurrently, then the filtered data are split into
+ * blocks compressed independently, each one primed with the last 32 KiB of
+ * its predecessor. Sync flushes make the blocks byte aligned, so they join
+ * into a single valid zlib stream whose checksum is combined from the
+ * checksums of the blocks.
+ */
+void write_parallel(WriterState& state, std::span<const std::byte> rows) {
+	std::size_t bpp = state.channels * std::size_t(state.bit_depth / 8);
+	std::size_t row_size = std::size_t(state.width) * bpp;
+	std::size_t height = state.height;
+	assert(rows.size() == row_size * height);
+
+	std::vector<std::byte> filtered(height * (row_size + 1));
+	std::size_t rows_per_task = std::max<std::size_t>(1, 65536 / row_size);
+	ssimp::parallel::parallel_for(
+	    (height + rows_per_task - 1) / rows_per_task,
+	    [&](std::size_t task) {
+		    std::size_t first = task * rows_per_task;
+		    std::size_t count = std::min(rows_per_task, height - first);
+		    filter_rows(rows, row_size, bpp, state.filters, first, count,
+		                std::span(filtered).subspan(first * (row_size + 1)));
+	    },
+	    state.threads);
+
+	constexpr std::size_t window_size = 32768;
+
+	std::size_t block_size = std::max(state.block_size, window_size);
+	std::vector<DeflatedBlock> blocks((filtered.size() + block_size - 1) /
+	                                  block_size);
+	ssimp::parallel::parallel_for(
+	    blocks.size(),
+	    [&](std::size_t i) {
+		    std::size_t begin = i * block_size;
+		    std::size_t size = std::min(block_size, filtered.size() - begin);
+		    std::size_t dictionary_size = std::min(begin, window_size);
+		    blocks[i] = deflate_block(
+		        std::span(filtered).subspan(begin, size),
+		        std::span(filtered).subspan(begin - dictionary_size,
+		                                    dictionary_size),
+		        i + 1 == blocks.size(), state.level, state.strategy);
+	    },
+	    state.threads);
+
+	uLong adler = adler32(0, nullptr, 0);
+	for (std::size_t i = 0; i < blocks.size(); ++i) {
+		std::size_t size =
+		    std::min(block_size, filtered.size() - i * block_size);
+		adler = adler32_combine(adler, blocks[i].adler, z_off_t(size));
+	}
+
+	// zlib header with the level hint, its check bits make it divisible by 31
+	int level = state.level < 0 ? 6 : state.level;
+	int level_hint = level < 2 ? 0 : level < 6 ? 1 : level == 6 ? 2 : 3;
+	std::array header{std::byte(0x78), std::byte(level_hint << 6)};
+	header[1] |= std::byte((31 - (0x78 * 256 + (level_hint << 6)) % 31) % 31);
+	std::array trailer{std::byte(adler >> 24), std::byte(adler >> 16),
+	                   std::byte(adler >> 8), std::byte(adler)};
+
+	for (std::size_t i = 0; i < blocks.size(); ++i) {
+		std::span<const std::byte> prefix, suffix;
+		if (i == 0)
+			prefix = header;
+		if (i + 1 == blocks.size())
+			suffix = trailer;
+		write_chunk(state, "IDAT", {prefix, blocks[i].data, suffix});
+	}
+	write_chunk(state, "IEND", {});
+}
+
+/**
+ * Pick filters and strategy requested to be chosen automatically. Candidates
+ * are compared by the compressed size of a few bands of **rows** (in the
+ * byte order of the file) spread over the image.
+ */
+void choose_settings(WriterState& state, std::span<const std::byte> rows) {
+	constexpr std::size_t band_count = 4;
+	constexpr std::size_t band_height = 8;
+
+	std::size_t bpp = state.channels * std::size_t(state.bit_depth / 8);
+	std::size_t row_size = std::size_t(state.width) * bpp;
+	std::size_t height = state.height;
+	std::size_t rows_per_band = std::min(band_height, height);
+
+	std::vector<std::uint8_t> filter_candidates{state.filters};
+	if (state.auto_filters)
+		filter_candidates = {1, 2, 4, 8, 16, all_filters};
+	std::vector<int> strategy_candidates{state.strategy};
+	if (state.auto_strategy)
+		strategy_candidates = {Z_FILTERED, Z_DEFAULT_STRATEGY, Z_RLE,
+		                       Z_HUFFMAN_ONLY};
+
+	std::vector<std::byte> sample(band_count * rows_per_band * (row_size + 1));
+	std::size_t best_size = std::numeric_limits<std::size_t>::max();
+	for (std::uint8_t filters : filter_candidates) {
+		for (std::size_t band = 0; band < band_count; ++band) {
+			std::size_t first =
+			    band * (height - rows_per_band) / (band_count - 1);
+			filter_rows(rows, row_size, bpp, filters, first, rows_per_band,
+			            std::span(sample).subspan(band * rows_per_band *
+			                                      (row_size + 1)));
+		}
+
+		for (int strategy : strategy_candidates) {
+			std::size_t size =
+			    deflate_block(sample, {}, true, state.level, strategy)
+			        .data.size();
+			if (size < best_size) {
+				best_size = size;
+				state.filters = filters;
+				state.strategy = strategy;
+			}
+		}
+	}
+}
+
+/**
+ * Mirror of the libpng simplified API decision, whether the file gamma
+ * differs from sRGB enough to be corrected.
+ */
+bool gamma_not_srgb(png_fixed_point gamma) {
+	if (gamma == 0)
+		return false;
+	if (gamma >= PNG_FP_1)
+		return true;
+
+	png_fixed_point display_gamma = (gamma * 11 + 2) / 5;
+	return display_gamma < PNG_FP_1 - 5000 || display_gamma > PNG_FP_1 + 5000;
+}
+
+/**
+ * Decode whole image row by row directly into a new image of type **T**.
+ */
+template <typename T>
+std::optional<std::vector<ssimp::img::LocalizedImage>>
+decode_rows(ssimp::formats::PNG::RowReader& reader) {
+	std::array dims{std::size_t(reader.width()), std::size_t(reader.height())};
+	ssimp::img::ndImage<T> typed_img(dims);
+	auto data = std::as_writable_bytes(typed_img.span());
+	std::size_t row_size = dims[0] * sizeof(T);
+
+	for (std::size_t pass = 0; pass < reader.passes(); ++pass)
+		for (std::size_t y = 0; y < dims[1]; ++y)
+			if (!reader.read_row(data.subspan(y * row_size, row_size)))
+				return {};
+
+	if (!reader.finish())
+		return {};
+
+	return std::vector<ssimp::img::LocalizedImage>{{typed_img}};
+}
+
+/**
+ * Decode image with already read header, the type of the output is given by
+ * the channel count.
+ */
+std::optional<std::vector<ssimp::img::LocalizedImage>>
+decode_rows_by_channels(ssimp::formats::PNG::RowReader& reader) {
+	using namespace ssimp::img;
+
+	if (reader.bit_depth() == 16)
+		return reader.channels() == 1 ? decode_rows<GRAY_16>(reader)
+		                              : std::nullopt;
+
+	switch (reader.channels()) {
+	case 1:
+		return decode_rows<GRAY_8>(reader);
+	case 2:
+		return decode_rows<GRAYA_8>(reader);
+	case 3:
+		return decode_rows<RGB_8>(reader);
+	case 4:
+		return decode_rows<RGBA_8>(reader);
+	}
+	return {};
+}
+
+/**
+ * Encode **img_** row by row using **writer**.
+ */
+template <typename T>
+void encode_rows(const ssimp::img::ndImage<T>& img_,
+                 ssimp::formats::PNG::RowWriter& writer) {
+	writer.write_image(std::as_bytes(img_.span()));
+}
+
+/**
+ * Encode **img_** row by row using **writer** after conversion of colour
+ * samples to 16-bit linear ones. Alpha is only widened.
+ */
+template <typename T>
+void encode_linear_rows(const ssimp::img::ndImage<T>& img_,
+                        ssimp::formats::PNG::RowWriter& writer) {
+	constexpr std::size_t channels = sizeof(T);
+	constexpr std::size_t colors = channels % 2 == 0 ? channels - 1 : channels;
+	const auto& table = linear_table();
+
+	auto data = std::as_bytes(img_.span());
+	std::size_t width = img_.dims()[0];
+	std::size_t height = img_.dims()[1];
+
+	std::size_t buffered_rows = writer.needs_whole_image() ? height : 1;
+	std::vector<std::uint16_t> rows(width * channels * buffered_rows);
+
+	for (std::size_t y = 0; y < height; ++y) {
+		auto src = reinterpret_cast<const std::uint8_t*>(data.data()) +
+		           y * width * channels;
+		auto dst = rows.data() + (y % buffered_rows) * width * channels;
+		for (std::size_t x = 0; x < width; ++x) {
+			for (std::size_t c = 0; c < colors; ++c)
+				dst[x * channels + c] = table[src[x * channels + c]];
+			if constexpr (colors != channels)
+				dst[x * channels + colors] =
+				    std::uint16_t(src[x * channels + colors] * 257);
+		}
+		if (!writer.needs_whole_image())
+			writer.write_row(std::as_bytes(std::span(rows)));
+	}
+
+	if (writer.needs_whole_image())
+		writer.write_image(std::as_bytes(std::span(rows)));
+	else
+		writer.finish();
+}
+
+/**
+ * Encode **img_** using **writer**, the colorspace was given to the writer.
+ */
+template <typename T>
+void encode_image_rows(const ssimp::img::ndImage<T>& img_,
+                       const std::string& colorspace,
+                       ssimp::formats::PNG::RowWriter& writer) {
+	if constexpr (bit_depth<T> == 8)
+		if (colorspace.starts_with("Linear "))
+			return encode_linear_rows(img_, writer);
+
+	encode_rows(img_, writer);
+}
+} // namespace
+
+namespace ssimp::formats {
+
+struct PNG::RowReader::_impl_t : StreamState {
+	~_impl_t() { png_destroy_read_struct(&png, &info, nullptr); }
+
+	std::size_t width = 0;
+	std::size_t height = 0;
+	std::size_t channels = 0;
+	std::size_t bit_depth = 8;
+	std::size_t passes = 1;
+	bool color_managed = false;
+};
+
+PNG::RowReader::RowReader(std::istream& input)
+    : _impl(std::make_unique<_impl_t>()) {
+	_impl->input = &input;
+	init_reader(*_impl);
+}
+
+PNG::RowReader::RowReader(std::span<const std::byte> input)
+    : _impl(std::make_unique<_impl_t>()) {
+	_impl->input_memory = input;
+	init_reader(*_impl);
+}
+
+PNG::RowReader::RowReader(RowReader&&) noexcept = default;
+PNG::RowReader& PNG::RowReader::operator=(RowReader&&) noexcept = default;
+PNG::RowReader::~RowReader() = default;
+
+bool PNG::RowReader::read_header() {
+	_impl_t& impl = *_impl;
+	if (setjmp(png_jmpbuf(impl.png)))
+		return false;
+
+	png_read_info(impl.png, impl.info);
+
+	// plain 16-bit grayscale is kept as it is
+	bool gray_16 =
+	    png_get_bit_depth(impl.png, impl.info) == 16 &&
+	    png_get_color_type(impl.png, impl.info) == PNG_COLOR_TYPE_GRAY &&
+	    !png_get_valid(impl.png, impl.info, PNG_INFO_tRNS);
+
+	png_fixed_point gamma = 0;
+	png_get_gAMA_fixed(impl.png, impl.info, &gamma);
+	impl.color_managed =
+	    !gray_16 && (png_get_bit_depth(impl.png, impl.info) == 16 ||
+	                 gamma_not_srgb(gamma));
+
+	if (gray_16) {
+		impl.bit_depth = 16;
+		if (std::endian::native == std::endian::little)
+			png_set_swap(impl.png);
+	} else {
+		png_set_expand(impl.png);
+		png_set_strip_16(impl.png);
+	}
+	impl.passes = std::size_t(png_set_interlace_handling(impl.png));
+	png_read_update_info(impl.png, impl.info);
+
+	impl.width = png_get_image_width(impl.png, impl.info);
+	impl.height = png_get_image_height(impl.png, impl.info);
+	impl.channels = png_get_channels(impl.png, impl.info);
+	return true;
+}
+
+std::size_t PNG::RowReader::width() const { return _impl->width; }
+std::size_t PNG::RowReader::height() const { return _impl->height; }
+std::size_t PNG::RowReader::channels() const { return _impl->channels; }
+std::size_t PNG::RowReader::bit_depth() const { return _impl->bit_depth; }
+std::size_t PNG::RowReader::passes() const { return _impl->passes; }
+
+bool PNG::RowReader::needs_color_management() const {
+	return _impl->color_managed;
+}
+
+bool PNG::RowReader::read_row(std::span<std::byte> row) {
+	assert(row.size() ==
+	       _impl->width * _impl->channels * _impl->bit_depth / 8);
+
+	if (setjmp(png_jmpbuf(_impl->png)))
+		return false;
+
+	png_read_row(_impl->png, reinterpret_cast<png_bytep>(row.data()),
+	             nullptr);
+	return true;
+}
+
+bool PNG::RowReader::finish() {
+	if (setjmp(png_jmpbuf(_impl->png)))
+		return false;
+
+	png_read_end(_impl->png, nullptr);
+	return true;
+}
+
+struct PNG::RowWriter::_impl_t : WriterState {
+	~_impl_t() { png_destroy_write_struct(&png, &info); }
+};
+
+
+PNG::RowWriter::RowWriter(std::ostream& output,
+                          std::size_t width,
+                          std::size_t height,
+                          std::size_t channels,
+                          std::size_t bit_depth,
+                          const option_types::options_t& options)
+    : _impl(std::make_unique<_impl_t>()) {
+	_impl->output = &output;
+	setup_writer(*_impl, width, height, channels, bit_depth, options);
+}
+
+PNG::RowWriter::RowWriter(std::vector<std::byte>& output,
+                          std::size_t width,
+                          std::size_t height,
+                          std::size_t channels,
+                          std::size_t bit_depth,
+                          const option_types::options_t& options)
+    : _impl(std::make_unique<_impl_t>()) {
+	_impl->output_memory = &output;
+	setup_writer(*_impl, width, height, channels, bit_depth, options);
+}
+
+PNG::RowWriter::RowWriter(RowWriter&&) noexcept = default;
+PNG::RowWriter& PNG::RowWriter::operator=(RowWriter&&) noexcept = default;
+PNG::RowWriter::~RowWriter() = default;
+
+void PNG::RowWriter::write_row(std::span<const std::byte> row) {
+	_impl_t& impl = *_impl;
+	assert(row.size() ==
+	       impl.width * impl.channels * std::size_t(impl.bit_depth / 8));
+
+	if (setjmp(png_jmpbuf(impl.png)))
+		throw exceptions::IOError(
+		    std::format("PNG encoding failed: '{}'", impl.error));
+
+	if (!impl.header_written) {
+		impl.header_written = true;
+		write_header(impl);
+	}
+
+	png_write_row(impl.png, reinterpret_cast<png_const_bytep>(row.data()));
+}
+
+bool PNG::RowWriter::needs_whole_image() const {
+	return _impl->parallel || _impl->auto_filters || _impl->auto_strategy;
+}
+
+void PNG::RowWriter::write_image(std::span<const std::byte> rows) {
+	_impl_t& impl = *_impl;
+	assert(!impl.header_written);
+	std::size_t row_size = rows.size() / impl.height;
+
+	// 16-bit samples are stored as big endian
+	std::vector<std::byte> swapped;
+	std::span<const std::byte> stored = rows;
+	if (needs_whole_image() && impl.bit_depth == 16 &&
+	    std::endian::native == std::endian::little) {
+		swapped.assign(rows.begin(), rows.end());
+		for (std::size_t i = 0; i < swapped.size(); i += 2)
+			std::swap(swapped[i], swapped[i + 1]);
+		stored = swapped;
+	}
+
+	if (impl.auto_filters || impl.auto_strategy)
+		choose_settings(impl, stored);
+
+	if (!impl.parallel) {
+		for (std::size_t y = 0; y < impl.height; ++y)
+			write_row(rows.subspan(y * row_size, row_size));
+		finish();
+		return;
+	}
+
+	if (setjmp(png_jmpbuf(impl.png)))
+		throw exceptions::IOError(
+		    std::format("PNG encoding failed: '{}'", impl.error));
+
+	impl.header_written = true;
+	write_header(impl);
+
+	// no more libpng calls, the rest is written directly
+	write_parallel(impl, stored);
+}
+
+void PNG::RowWriter::finish() {
+	_impl_t& impl = *_impl;
+	if (setjmp(png_jmpbuf(impl.png)))
+		throw exceptions::IOError(
+		    std::format("PNG encoding failed: '{}'", impl.error));
+
+	png_write_end(impl.png, nullptr);
+}
+
+/* static */ bool PNG::image_count_supported(std::size_t count) {
+	return count == 1;
+}
+
+/* static */ bool PNG::image_dims_supported(std::span<const std::size_t> dims) {
+	return dims.size() == 2 && dims[0] > 0 && dims[1] > 0;
+}
+
+/* static */ std::optional<std::vector<img::LocalizedImage>>
+PNG::load_image(const std::filesystem::path& path,
+                const option_types::options_t& options) {
+	std::string str_path = path.string();
+
+	{
+		std::ifstream file(path, std::ios::binary);
+		if (!file)
+			return {};
+
+		RowReader reader(file);
+		if (!reader.read_header())
+			return {};
+		if (!reader.needs_color_management())
+			return decode_rows_by_channels(reader);
+	}
+
+	png_image image;
+	std::memset(&image, 0, sizeof(png_image));
+	image.version = PNG_IMAGE_VERSION;
+
+	if (!png_image_begin_read_from_file(&image, str_path.c_str()))
+		return {};
+
+	return finish_loading(image);
+}
+
+/* static */ std::optional<std::vector<img::LocalizedImage>>
+PNG::load_image_from_memory(std::span<const std::byte> bytes,
+                            const option_types::options_t& options) {
+	RowReader reader(bytes);
+	if (!reader.read_header())
+		return {};
+	if (!reader.needs_color_management())
+		return decode_rows_by_channels(reader);
+
+	png_image image;
+	std::memset(&image, 0, sizeof(png_image));
+	image.version = PNG_IMAGE_VERSION;
+
+	if (!png_image_begin_read_from_memory(&image, bytes.data(), bytes.size()))
+		return {};
+
+	return finish_loading(image);
+}
+
 /* static */ std::optional<ImageProperties>
 PNG::get_information(const std::filesystem::path& path,
                      const option_types::options_t& options) {
 	std::string str_path = path.string();
 	ImageProperties props{name};
 
+	{
+		std::ifstream file(path, std::ios::binary);
+		if (!file)
+			return {};
+
+		RowReader reader(file);
+		if (!reader.read_header())
+			return {};
+		if (reader.bit_depth() == 16) {
+			props.dims = {reader.width(), reader.height()};
+			props.others["Colorspace"] = to_string(img::elem_type::GRAY_16);
+			return props;
+		}
+	}
+
 	// initialization
 	png_image image;
 	std::memset(&image, 0, sizeof(png_image));
@@ -164,81 +1079,33 @@ template <typename T>
 /* static */ void PNG::save_image(const std::vector<img::ndImage<T>>& imgs,
                                   const std::filesystem::path& path,
                                   const option_types::options_t& options) {
+	std::string colorspace = std::get<std::string>(options.at("colorspace"));
+	check_colorspace<T>(colorspace);
 
-	std::string str_path = path.string();
-	const auto& img_ = imgs[0];
-
-	// initialization
-	png_image image;
-	std::memset(&image, 0, sizeof(png_image));
-
-	image.width = png_uint_32(img_.dims()[0]);
-	image.height = png_uint_32(img_.dims()[1]);
-	image.version = PNG_IMAGE_VERSION;
-	if constexpr (std::is_same_v<T, img::GRAY_8>)
-		image.format = PNG_FORMAT_GRAY;
-	if constexpr (std::is_same_v<T, img::GRAYA_8>)
-		image.format = PNG_FORMAT_GA;
-	else if constexpr (std::is_same_v<T, img::RGB_8>)
-		image.format = PNG_FORMAT_RGB;
-	else if constexpr (std::is_same_v<T, img::RGBA_8>)
-		image.format = PNG_FORMAT_RGBA;
-	if (std::get<bool>(options.at("fast_save")))
-		image.flags |= PNG_IMAGE_FLAG_FAST;
-
-	const void* buffer = img_.span().data();
+	details::AtomicFileWriter file(path);
+	RowWriter writer(file.stream(), imgs[0].dims()[0], imgs[0].dims()[1],
+	                 channel_count<T>, bit_depth<T>, options);
+	encode_image_rows(imgs[0], colorspace, writer);
+	file.commit();
+}
 
+template <typename T>
+    requires mt::traits::is_any_of_tuple_v<T, PNG::supported_types>
+/* static */ std::vector<std::byte>
+PNG::encode_image(const std::vector<img::ndImage<T>>& imgs,
+                  const option_types::options_t& options) {
 	std::string colorspace = std::get<std::string>(options.at("colorspace"));
+	check_colorspace<T>(colorspace);
 
-	std::vector<std::byte> new_image_buffer;
-	if (colorspace != "auto") {
-		if (PNG_IMAGE_SAMPLE_CHANNELS(image.format) !=
-		    PNG_IMAGE_SAMPLE_CHANNELS(string_to_format(colorspace)))
-			throw ssimp::exceptions::Unsupported(std::format(
-			    "Cannot convert images to different channel size, got: {}, "
-			    "requested: {}",
-			    PNG_IMAGE_SAMPLE_CHANNELS(image.format),
-			    PNG_IMAGE_SAMPLE_CHANNELS(string_to_format(colorspace))));
-
-		png_alloc_size_t mem_size;
-		if (!png_image_write_get_memory_size(image, mem_size, false, buffer, 0,
-		                                     nullptr))
-			throw ssimp::exceptions::IOError(std::format(
-			    "Obtaining memory requirements ended with message: '{}'",
-			    image.message));
-		std::vector<std::byte> mem_image(mem_size);
-		if (!png_image_write_to_memory(&image, mem_image.data(), &mem_size,
-		                               false, buffer, 0, nullptr))
-			throw ssimp::exceptions::IOError(std::format(
-			    "Writing to memory ended with message: '{}'", image.message));
-
-		png_image new_image;
-		std::memset(&new_image, 0, sizeof(png_image));
-		new_image.version = PNG_IMAGE_VERSION;
-		if (!png_image_begin_read_from_memory(&new_image, mem_image.data(),
-		                                      mem_image.size()))
-			throw ssimp::exceptions::IOError(std::format(
-			    "Begin reading of image from memory ended with message: '{}'",
-			    new_image.message));
-
-		new_image.format = string_to_format(colorspace);
-		new_image_buffer.resize(PNG_IMAGE_SIZE(new_image));
-		if (!png_image_finish_read(&new_image, nullptr, new_image_buffer.data(),
-		                           0, nullptr))
-			throw ssimp::exceptions::IOError(std::format(
-			    "Finish reading of image from memory ended with message: '{}'",
-			    new_image.message));
-		buffer = new_image_buffer.data();
-		image.format = new_image.format;
-	}
-
-	if (!png_image_write_to_file(&image, str_path.c_str(), false, buffer, 0,
-	                             nullptr))
-		throw ssimp::exceptions::IOError(std::format(
-		    "Could not write: {}; (message: '{}')", str_path, image.message));
+	std::vector<std::byte> out;
+	RowWriter writer(out, imgs[0].dims()[0], imgs[0].dims()[1],
+	                 channel_count<T>, bit_depth<T>, options);
+	encode_image_rows(imgs[0], colorspace, writer);
+	return out;
 }
 
 INSTANTIATE_SAVE_TEMPLATE(PNG, img::GRAY_8);
+INSTANTIATE_SAVE_TEMPLATE(PNG, img::GRAY_16);
 INSTANTIATE_SAVE_TEMPLATE(PNG, img::GRAYA_8);
 INSTANTIATE_SAVE_TEMPLATE(PNG, img::RGB_8);
 INSTANTIATE_SAVE_TEMPLATE(PNG, img::RGBA_8);
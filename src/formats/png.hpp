@@ -5,8 +5,11 @@
 namespace ssimp::formats {
 class PNG {
   public:
-	using supported_types =
-	    std::tuple<img::GRAY_8, img::GRAYA_8, img::RGB_8, img::RGBA_8>;
+	using supported_types = std::tuple<img::GRAY_8,
+	                                   img::GRAYA_8,
+	                                   img::GRAY_16,
+	                                   img::RGB_8,
+	                                   img::RGBA_8>;
 	constexpr static const char* name = "png";
 
 	static bool image_count_supported(std::size_t count);
@@ -17,14 +20,132 @@ class PNG {
 	load_image(const std::filesystem::path& path,
 	           const option_types::options_t& options);
 
+	static std::optional<std::vector<img::LocalizedImage>>
+	load_image_from_memory(std::span<const std::byte> bytes,
+	                       const option_types::options_t& options);
+
 	template <typename T>
 	    requires mt::traits::is_any_of_tuple_v<T, PNG::supported_types>
 	static void save_image(const std::vector<img::ndImage<T>>& imgs,
 	                       const std::filesystem::path& path,
 	                       const option_types::options_t& options);
 
+	template <typename T>
+	    requires mt::traits::is_any_of_tuple_v<T, PNG::supported_types>
+	static std::vector<std::byte>
+	encode_image(const std::vector<img::ndImage<T>>& imgs,
+	             const option_types::options_t& options);
+
 	static std::optional<ImageProperties>
 	get_information(const std::filesystem::path& path,
 	                const option_types::options_t& options);
+
+	/**
+	 * Incremental decoder producing rows one by one, so only a few rows need
+	 * to be kept in memory. Samples are expanded to 8-bit GRAY, GRAY + alpha,
+	 * RGB or RGBA (given by **channels()**). Only 16-bit grayscale images
+	 * without transparency keep native endian 16-bit samples.
+	 */
+	class RowReader {
+	  public:
+		explicit RowReader(std::istream& input);
+		explicit RowReader(std::span<const std::byte> input);
+		RowReader(RowReader&&) noexcept;
+		RowReader& operator=(RowReader&&) noexcept;
+		~RowReader();
+
+		/**
+		 * Read everything up to the image data. Return false if the input
+		 * is not a valid PNG.
+		 */
+		bool read_header();
+
+		std::size_t width() const;
+		std::size_t height() const;
+		std::size_t channels() const;
+		std::size_t bit_depth() const;
+
+		/**
+		 * Number of passes over the rows, more than one for interlaced
+		 * images. Rows of such images are complete only after the last pass
+		 * (each pass fills in its pixels into the given row).
+		 */
+		std::size_t passes() const;
+
+		/**
+		 * True if the image is 16-bit (other than plain grayscale) or its
+		 * gamma is not sRGB, so the rows would not match the colour managed
+		 * decoding of **load_image**.
+		 */
+		bool needs_color_management() const;
+
+		/**
+		 * Decode next row into **row** of **width()** * **channels()**
+		 * samples. Return false on corrupted data.
+		 */
+		bool read_row(std::span<std::byte> row);
+
+		/**
+		 * Read the rest of the file after the last row.
+		 */
+		bool finish();
+
+	  private:
+		struct _impl_t;
+		std::unique_ptr<_impl_t> _impl;
+	};
+
+	/**
+	 * Incremental encoder consuming rows one by one, the output is written
+	 * as soon as it is compressed. Rows hold samples of **bit_depth** (8 or
+	 * 16, native endian). With one of the "Linear" colorspaces requested in
+	 * **options**, 16-bit linear samples are expected.
+	 */
+	class RowWriter {
+	  public:
+		RowWriter(std::ostream& output,
+		          std::size_t width,
+		          std::size_t height,
+		          std::size_t channels,
+		          std::size_t bit_depth,
+		          const option_types::options_t& options);
+		RowWriter(std::vector<std::byte>& output,
+		          std::size_t width,
+		          std::size_t height,
+		          std::size_t channels,
+		          std::size_t bit_depth,
+		          const option_types::options_t& options);
+		RowWriter(RowWriter&&) noexcept;
+		RowWriter& operator=(RowWriter&&) noexcept;
+		~RowWriter();
+
+		/**
+		 * Compress and write next **row** of **width** * **channels**
+		 * samples. Header is written before the first row.
+		 */
+		void write_row(std::span<const std::byte> row);
+
+		/**
+		 * Write the end of the file, all rows have to be written before.
+		 */
+		void finish();
+
+		/**
+		 * Whether the options request parallel compression or automatic
+		 * choice of filters or strategy. These are used only by
+		 * **write_image**, as they need all rows at once.
+		 */
+		bool needs_whole_image() const;
+
+		/**
+		 * Write all **rows** (with no rows written before) and finish the
+		 * file.
+		 */
+		void write_image(std::span<const std::byte> rows);
+
+	  private:
+		struct _impl_t;
+		std::unique_ptr<_impl_t> _impl;
+	};
 };
 } // namespace ssimp::formats
@@ -0,0 +1,394 @@
+#include "pnm.hpp"
+#include "common_macro.hpp"
+#include <cctype>
+#include <charconv>
+#include <format>
+#include <string_view>
+
+namespace {
+using ssimp::img::elem_type;
+
+struct PnmHeader {
+	char variant; // '5', '6' or '7'
+	std::size_t width;
+	std::size_t height;
+	std::size_t depth;
+	std::uint32_t maxval;
+	std::size_t data_offset;
+
+	std::size_t sample_size() const { return maxval > 255 ? 2 : 1; }
+};
+
+/**
+ * Tokenizer of the textual header.
+ */
+class HeaderReader {
+  public:
+	explicit HeaderReader(std::string_view text) : _text(text) {}
+
+	/**
+	 * Skip whitespace and comments (from '#' to the end of line).
+	 */
+	void skip_space() {
+		while (_pos < _text.size()) {
+			if (_text[_pos] == '#')
+				while (_pos < _text.size() && _text[_pos] != '\n')
+					++_pos;
+			else if (std::isspace(static_cast<unsigned char>(_text[_pos])))
+				++_pos;
+			else
+				return;
+		}
+	}
+
+	/**
+	 * Next whitespace separated token on the current line.
+	 */
+	std::string_view token() {
+		while (_pos < _text.size() &&
+		       (_text[_pos] == ' ' || _text[_pos] == '\t'))
+			++_pos;
+		std::size_t start = _pos;
+		while (_pos < _text.size() &&
+		       !std::isspace(static_cast<unsigned char>(_text[_pos])))
+			++_pos;
+		return _text.substr(start, _pos - start);
+	}
+
+	std::optional<std::size_t> number() {
+		skip_space();
+		std::string_view text = token();
+		std::size_t value = 0;
+		auto [ptr, ec] =
+		    std::from_chars(text.data(), text.data() + text.size(), value);
+		if (ec != std::errc() || ptr != text.data() + text.size())
+			return {};
+		return value;
+	}
+
+	/**
+	 * Skip the rest of the current line including the line feed.
+	 */
+	void next_line() {
+		_pos = std::min(_text.find('\n', _pos), _text.size());
+		if (_pos < _text.size())
+			++_pos;
+	}
+
+	/**
+	 * Consume single whitespace character which ends the header.
+	 */
+	bool end_header() {
+		if (_pos >= _text.size() ||
+		    !std::isspace(static_cast<unsigned char>(_text[_pos])))
+			return false;
+		++_pos;
+		return true;
+	}
+
+	bool at_end() const { return _pos >= _text.size(); }
+	std::size_t position() const { return _pos; }
+
+  private:
+	std::string_view _text;
+	std::size_t _pos = 0;
+};
+
+/**
+ * Parse header of PAM image, that is the lines after "P7".
+ */
+bool parse_pam_header(HeaderReader& reader, PnmHeader& header) {
+	bool has_maxval = false;
+	while (true) {
+		reader.skip_space();
+		if (reader.at_end())
+			return false;
+
+		std::string_view key = reader.token();
+		if (key == "ENDHDR") {
+			reader.next_line();
+			break;
+		}
+
+		if (key == "TUPLTYPE") {
+			reader.next_line();
+			continue;
+		}
+
+		std::optional<std::size_t> value = reader.number();
+		if (!value)
+			return false;
+		if (key == "WIDTH")
+			header.width = *value;
+		else if (key == "HEIGHT")
+			header.height = *value;
+		else if (key == "DEPTH")
+			header.depth = *value;
+		else if (key == "MAXVAL") {
+			header.maxval = std::uint32_t(std::min<std::size_t>(*value, 65536));
+			has_maxval = true;
+		} else
+			return false;
+	}
+
+	return has_maxval && header.depth >= 1 && header.depth <= 4;
+}
+
+/**
+ * Parse header of binary PGM, PPM or PAM image in **bytes**, return nothing
+ * if it is not a valid header or the data are truncated.
+ */
+std::optional<PnmHeader> parse_header(std::span<const std::byte> bytes) {
+	// the longest valid header is far below this limit
+	std::string_view text(reinterpret_cast<const char*>(bytes.data()),
+	                      std::min<std::size_t>(bytes.size(), 4096));
+	if (text.size() < 3 || text[0] != 'P' ||
+	    (text[1] != '5' && text[1] != '6' && text[1] != '7'))
+		return {};
+
+	PnmHeader header{text[1], 0, 0, std::size_t(text[1] == '6' ? 3 : 1), 0,
+	                 0};
+	HeaderReader reader(text.substr(2));
+
+	if (header.variant == '7') {
+		if (!parse_pam_header(reader, header))
+			return {};
+	} else {
+		auto width = reader.number();
+		auto height = reader.number();
+		auto maxval = reader.number();
+		if (!width || !height || !maxval || !reader.end_header())
+			return {};
+		header.width = *width;
+		header.height = *height;
+		header.maxval = std::uint32_t(std::min<std::size_t>(*maxval, 65536));
+	}
+
+	header.data_offset = 2 + reader.position();
+	if (header.width == 0 || header.height == 0 || header.maxval == 0 ||
+	    header.maxval > 65535)
+		return {};
+
+	// checked by division, products of huge dimensions would wrap around
+	std::size_t available = bytes.size() - header.data_offset;
+	std::size_t pixel_size = header.depth * header.sample_size();
+	if (header.width > available / pixel_size ||
+	    header.height > available / (header.width * pixel_size))
+		return {};
+	return header;
+}
+
+std::optional<elem_type> image_type(const PnmHeader& header) {
+	if (header.sample_size() == 2)
+		return header.depth == 1 ? std::optional(elem_type::GRAY_16)
+		                         : std::nullopt;
+
+	constexpr std::array types{elem_type::GRAY_8, elem_type::GRAYA_8,
+	                           elem_type::RGB_8, elem_type::RGBA_8};
+	return types[header.depth - 1];
+}
+
+/**
+ * Scale samples in range [0, **maxval**] to [0, **full**].
+ */
+template <typename sample_t>
+void scale_samples(std::span<sample_t> samples,
+                   std::uint32_t maxval,
+                   std::uint32_t full) {
+	for (sample_t& sample : samples)
+		sample = sample_t(
+		    (std::min(std::uint32_t(sample), maxval) * full + maxval / 2) /
+		    maxval);
+}
+
+/**
+ * Create image of type **T** from samples in **data**. If **owner** is given
+ * and the samples need no conversion, the image refers directly to **data**.
+ */
+template <typename T>
+ssimp::img::ndImageBase create_image(const PnmHeader& header,
+                                     std::span<std::byte> data,
+                                     std::shared_ptr<void> owner) {
+	std::array dims{header.width, header.height};
+	std::size_t count = header.width * header.height;
+
+	if constexpr (std::is_same_v<T, ssimp::img::GRAY_16>) {
+		ssimp::img::ndImage<T> out(dims);
+		std::span<std::uint16_t> samples = out.span();
+		for (std::size_t i = 0; i < count; ++i) {
+			auto high = std::to_integer<std::uint16_t>(data[2 * i]);
+			auto low = std::to_integer<std::uint16_t>(data[2 * i + 1]);
+			samples[i] = std::uint16_t(high << 8 | low);
+		}
+		if (header.maxval != 65535)
+			scale_samples(samples, header.maxval, 65535);
+		return out;
+	} else {
+		data = data.first(count * sizeof(T));
+		if (owner && header.maxval == 255)
+			return ssimp::img::ndImage<T>(
+			    dims, std::move(owner),
+			    std::span(reinterpret_cast<T*>(data.data()), count));
+
+		ssimp::img::ndImage<T> out(dims);
+		auto out_bytes = std::as_writable_bytes(out.span());
+		std::ranges::copy(data, out_bytes.begin());
+		if (header.maxval != 255)
+			scale_samples(
+			    std::span(reinterpret_cast<std::uint8_t*>(out_bytes.data()),
+			              out_bytes.size()),
+			    header.maxval, 255);
+		return out;
+	}
+}
+
+std::optional<std::vector<ssimp::img::LocalizedImage>>
+load_pnm(std::span<std::byte> bytes, std::shared_ptr<void> owner) {
+	std::optional<PnmHeader> header = parse_header(bytes);
+	if (!header)
+		return {};
+
+	std::optional<elem_type> type = image_type(*header);
+	if (!type)
+		throw ssimp::exceptions::Unsupported(
+		    "16-bit netpbm images are supported only with single channel");
+
+	std::span<std::byte> data = bytes.subspan(header->data_offset);
+	ssimp::img::ndImageBase out = ssimp::img::ndImage<ssimp::img::GRAY_8>(1);
+	switch (*type) {
+	case elem_type::GRAY_8:
+		out = create_image<ssimp::img::GRAY_8>(*header, data, owner);
+		break;
+	case elem_type::GRAYA_8:
+		out = create_image<ssimp::img::GRAYA_8>(*header, data, owner);
+		break;
+	case elem_type::GRAY_16:
+		out = create_image<ssimp::img::GRAY_16>(*header, data, owner);
+		break;
+	case elem_type::RGB_8:
+		out = create_image<ssimp::img::RGB_8>(*header, data, owner);
+		break;
+	default:
+		out = create_image<ssimp::img::RGBA_8>(*header, data, owner);
+		break;
+	}
+
+	return std::vector<ssimp::img::LocalizedImage>{{out}};
+}
+
+/**
+ * Header for **img**, PGM for grayscale, PPM for RGB and PAM otherwise.
+ */
+template <typename T>
+std::string create_header(const ssimp::img::ndImage<T>& img) {
+	std::size_t width = img.dims()[0];
+	std::size_t height = img.dims()[1];
+
+	if constexpr (std::is_same_v<T, ssimp::img::GRAY_8>)
+		return std::format("P5\n{} {}\n255\n", width, height);
+	else if constexpr (std::is_same_v<T, ssimp::img::GRAY_16>)
+		return std::format("P5\n{} {}\n65535\n", width, height);
+	else if constexpr (std::is_same_v<T, ssimp::img::RGB_8>)
+		return std::format("P6\n{} {}\n255\n", width, height);
+	else
+		return std::format(
+		    "P7\nWIDTH {}\nHEIGHT {}\nDEPTH {}\nMAXVAL 255\nTUPLTYPE {}\n"
+		    "ENDHDR\n",
+		    width, height, std::tuple_size_v<T>,
+		    std::tuple_size_v<T> == 2 ? "GRAYSCALE_ALPHA" : "RGB_ALPHA");
+}
+
+/**
+ * Samples of **img** as stored in the file, 16-bit samples are converted to
+ * big endian in **buffer**, other images are referred to directly.
+ */
+template <typename T>
+std::span<const std::byte> image_data(const ssimp::img::ndImage<T>& img,
+                                      std::vector<std::byte>& buffer) {
+	if constexpr (std::is_same_v<T, ssimp::img::GRAY_16>) {
+		buffer.resize(img.span().size_bytes());
+		std::size_t i = 0;
+		for (std::uint16_t sample : img) {
+			buffer[i++] = std::byte(sample >> 8);
+			buffer[i++] = std::byte(sample & 0xff);
+		}
+		return buffer;
+	} else
+		return std::as_bytes(img.span());
+}
+} // namespace
+
+namespace ssimp::formats {
+/* static */ bool PNM::image_count_supported(std::size_t count) {
+	return count == 1;
+}
+
+/* static */ bool PNM::image_dims_supported(std::span<const std::size_t> dims) {
+	return dims.size() == 2 && dims[0] > 0 && dims[1] > 0;
+}
+
+/* static */ std::optional<std::vector<img::LocalizedImage>>
+PNM::load_image(const std::filesystem::path& path,
+                const option_types::options_t& options) {
+	auto file = std::make_shared<details::MappedFile>(path, true);
+	return load_pnm(file->writable_bytes(), file);
+}
+
+/* static */ std::optional<std::vector<img::LocalizedImage>>
+PNM::load_image_from_memory(std::span<const std::byte> bytes,
+                            const option_types::options_t& options) {
+	// without an owner the data are only read from and copied
+	return load_pnm({const_cast<std::byte*>(bytes.data()), bytes.size()},
+	                nullptr);
+}
+
+template <typename T>
+    requires mt::traits::is_any_of_tuple_v<T, PNM::supported_types>
+/* static */ void PNM::save_image(const std::vector<img::ndImage<T>>& imgs,
+                                  const std::filesystem::path& path,
+                                  const option_types::options_t& options) {
+	std::string header = create_header(imgs[0]);
+	std::vector<std::byte> buffer;
+	std::array<std::span<const std::byte>, 2> parts{
+	    std::as_bytes(std::span(header)), image_data(imgs[0], buffer)};
+	details::save_file(path, parts);
+}
+
+template <typename T>
+    requires mt::traits::is_any_of_tuple_v<T, PNM::supported_types>
+/* static */ std::vector<std::byte>
+PNM::encode_image(const std::vector<img::ndImage<T>>& imgs,
+                  const option_types::options_t& options) {
+	std::string header = create_header(imgs[0]);
+	auto header_bytes = std::as_bytes(std::span(header));
+	std::vector<std::byte> out(header_bytes.begin(), header_bytes.end());
+	std::vector<std::byte> buffer;
+	std::span<const std::byte> data = image_data(imgs[0], buffer);
+	out.insert(out.end(), data.begin(), data.end());
+	return out;
+}
+
+/* static */ std::optional<ImageProperties>
+PNM::get_information(const std::filesystem::path& path,
+                     const option_types::options_t& options) {
+	details::MappedFile file(path);
+	std::optional<PnmHeader> header = parse_header(file.bytes());
+	if (!header)
+		return {};
+
+	ImageProperties out{name, {header->width, header->height}, {}};
+	out.others["Variant"] = header->variant == '5'   ? "PGM"
+	                        : header->variant == '6' ? "PPM"
+	                                                 : "PAM";
+	out.others["Channels"] = std::to_string(header->depth);
+	out.others["Maximal value"] = std::to_string(header->maxval);
+	return out;
+}
+
+INSTANTIATE_SAVE_TEMPLATE(PNM, img::GRAY_8);
+INSTANTIATE_SAVE_TEMPLATE(PNM, img::GRAYA_8);
+INSTANTIATE_SAVE_TEMPLATE(PNM, img::GRAY_16);
+INSTANTIATE_SAVE_TEMPLATE(PNM, img::RGB_8);
+INSTANTIATE_SAVE_TEMPLATE(PNM, img::RGBA_8);
+
+} // namespace ssimp::formats
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "common.hpp"
+
+namespace ssimp::formats {
+/**
+ * Binary netpbm images: PGM (P5) for GRAY_8 and GRAY_16, PPM (P6) for RGB_8
+ * and PAM (P7) for all supported types, notably GRAYA_8 and RGBA_8.
+ *
+ * Samples with maximal value other than 255 (or 65535 for 16-bit) are scaled
+ * to the full range when loaded.
+ */
+class PNM {
+  public:
+	using supported_types = std::tuple<img::GRAY_8,
+	                                   img::GRAYA_8,
+	                                   img::GRAY_16,
+	                                   img::RGB_8,
+	                                   img::RGBA_8>;
+	constexpr static const char* name = "pnm";
+
+	static bool image_count_supported(std::size_t count);
+	static bool image_dims_supported(std::span<const std::size_t> dims);
+	static constexpr bool same_dims_required() { return true; }
+
+	/**
+	 * The file is memory mapped copy-on-write and 8-bit images with full
+	 * range samples point directly into the mapping. 16-bit samples are
+	 * converted from big endian while copied.
+	 */
+	static std::optional<std::vector<img::LocalizedImage>>
+	load_image(const std::filesystem::path& path,
+	           const option_types::options_t& options);
+
+	static std::optional<std::vector<img::LocalizedImage>>
+	load_image_from_memory(std::span<const std::byte> bytes,
+	                       const option_types::options_t& options);
+
+	template <typename T>
+	    requires mt::traits::is_any_of_tuple_v<T, PNM::supported_types>
+	static void save_image(const std::vector<img::ndImage<T>>& imgs,
+	                       const std::filesystem::path& path,
+	                       const option_types::options_t& options);
+
+	template <typename T>
+	    requires mt::traits::is_any_of_tuple_v<T, PNM::supported_types>
+	static std::vector<std::byte>
+	encode_image(const std::vector<img::ndImage<T>>& imgs,
+	             const option_types::options_t& options);
+
+	static std::optional<ImageProperties>
+	get_information(const std::filesystem::path& path,
+	                const option_types::options_t& options);
+};
+} // namespace ssimp::formats
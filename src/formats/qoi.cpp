@@ -0,0 +1,288 @@
+#include "qoi.hpp"
+#include "common_macro.hpp"
+#include <limits>
+
+namespace {
+using Pixel = std::array<std::uint8_t, 4>;
+
+constexpr std::string_view magic = "qoif";
+constexpr std::size_t header_size = 14;
+constexpr std::array<std::uint8_t, 8> end_marker{0, 0, 0, 0, 0, 0, 0, 1};
+
+constexpr std::uint8_t op_index = 0x00;
+constexpr std::uint8_t op_diff = 0x40;
+constexpr std::uint8_t op_luma = 0x80;
+constexpr std::uint8_t op_run = 0xc0;
+constexpr std::uint8_t op_rgb = 0xfe;
+constexpr std::uint8_t op_rgba = 0xff;
+constexpr std::uint8_t op_mask = 0xc0;
+constexpr int max_run = 62;
+
+std::size_t index_position(const Pixel& px) {
+	return (px[0] * 3 + px[1] * 5 + px[2] * 7 + px[3] * 11) % 64;
+}
+
+std::uint32_t read_u32(std::span<const std::byte> bytes) {
+	return std::uint32_t(bytes[0]) << 24 | std::uint32_t(bytes[1]) << 16 |
+	       std::uint32_t(bytes[2]) << 8 | std::uint32_t(bytes[3]);
+}
+
+struct QoiHeader {
+	std::uint32_t width;
+	std::uint32_t height;
+	std::uint8_t channels;
+	std::uint8_t colorspace;
+};
+
+std::optional<QoiHeader> read_header(std::span<const std::byte> bytes) {
+	if (bytes.size() < header_size + end_marker.size() ||
+	    !std::ranges::equal(std::as_bytes(std::span(magic)), bytes.first(4)))
+		return {};
+
+	QoiHeader header{read_u32(bytes.subspan(4)), read_u32(bytes.subspan(8)),
+	                 std::uint8_t(bytes[12]), std::uint8_t(bytes[13])};
+	if (header.width == 0 || header.height == 0 ||
+	    (header.channels != 3 && header.channels != 4) || header.colorspace > 1)
+		return {};
+
+	// every byte of the chunks encodes at most one run of max_run pixels
+	std::size_t payload = bytes.size() - header_size - end_marker.size();
+	std::size_t max_pixels = std::numeric_limits<std::size_t>::max();
+	if (header.height > max_pixels / header.width ||
+	    std::size_t(header.width) * header.height > payload * max_run)
+		return {};
+	return header;
+}
+
+/**
+ * Decode pixels following the header into image of type **T**, return
+ * nothing if the data are truncated.
+ */
+template <typename T>
+std::optional<ssimp::img::ndImageBase>
+decode_pixels(const QoiHeader& header, std::span<const std::byte> bytes) {
+	constexpr std::size_t channels = std::tuple_size_v<T>;
+	ssimp::img::ndImage<T> out(std::array{std::size_t(header.width),
+	                                      std::size_t(header.height)});
+
+	const auto* data = reinterpret_cast<const std::uint8_t*>(bytes.data());
+	// the end marker can not be part of any chunk
+	std::size_t end = bytes.size() - end_marker.size();
+	std::size_t pos = header_size;
+
+	std::array<Pixel, 64> index{};
+	Pixel px{0, 0, 0, 255};
+	int run = 0;
+
+	for (T& dest : out) {
+		if (run > 0) {
+			--run;
+		} else {
+			if (pos >= end)
+				return {};
+			std::uint8_t b1 = data[pos++];
+
+			if (b1 == op_rgb) {
+				if (end - pos < 3)
+					return {};
+				px[0] = data[pos++];
+				px[1] = data[pos++];
+				px[2] = data[pos++];
+			} else if (b1 == op_rgba) {
+				if (end - pos < 4)
+					return {};
+				px = {data[pos], data[pos + 1], data[pos + 2], data[pos + 3]};
+				pos += 4;
+			} else if ((b1 & op_mask) == op_index) {
+				px = index[b1];
+			} else if ((b1 & op_mask) == op_diff) {
+				px[0] += ((b1 >> 4) & 0x03) - 2;
+				px[1] += ((b1 >> 2) & 0x03) - 2;
+				px[2] += (b1 & 0x03) - 2;
+			} else if ((b1 & op_mask) == op_luma) {
+				if (pos >= end)
+					return {};
+				std::uint8_t b2 = data[pos++];
+				int vg = (b1 & 0x3f) - 32;
+				px[0] += vg - 8 + ((b2 >> 4) & 0x0f);
+				px[1] += vg;
+				px[2] += vg - 8 + (b2 & 0x0f);
+			} else {
+				run = b1 & 0x3f;
+			}
+
+			index[index_position(px)] = px;
+		}
+
+		std::copy_n(px.begin(), channels, dest.begin());
+	}
+
+	return out;
+}
+
+std::optional<std::vector<ssimp::img::LocalizedImage>>
+decode(std::span<const std::byte> bytes) {
+	std::optional<QoiHeader> header = read_header(bytes);
+	if (!header)
+		return {};
+
+	std::optional<ssimp::img::ndImageBase> out =
+	    header->channels == 3
+	        ? decode_pixels<ssimp::img::RGB_8>(*header, bytes)
+	        : decode_pixels<ssimp::img::RGBA_8>(*header, bytes);
+	if (!out)
+		return {};
+	return std::vector<ssimp::img::LocalizedImage>{{*out}};
+}
+
+template <typename T>
+std::vector<std::byte> encode(const ssimp::img::ndImage<T>& img) {
+	constexpr std::size_t channels = std::tuple_size_v<T>;
+	std::size_t width = img.dims()[0];
+	std::size_t height = img.dims()[1];
+
+	// worst case is a full RGB(A) chunk for every pixel
+	std::vector<std::byte> out_bytes(header_size + width * height *
+	                                                   (channels + 1) +
+	                                 end_marker.size());
+	auto* out = reinterpret_cast<std::uint8_t*>(out_bytes.data());
+	std::size_t pos = 0;
+
+	std::ranges::copy(magic, out);
+	pos += magic.size();
+	for (std::size_t value : {width, height})
+		for (int shift = 24; shift >= 0; shift -= 8)
+			out[pos++] = std::uint8_t(value >> shift);
+	out[pos++] = std::uint8_t(channels);
+	out[pos++] = 0; // sRGB with linear alpha
+
+	std::array<Pixel, 64> index{};
+	Pixel prev{0, 0, 0, 255};
+	Pixel px = prev;
+	int run = 0;
+
+	for (const T& src : img) {
+		std::copy_n(src.begin(), channels, px.begin());
+
+		if (px == prev) {
+			if (++run == max_run) {
+				out[pos++] = op_run | std::uint8_t(run - 1);
+				run = 0;
+			}
+			continue;
+		}
+
+		if (run > 0) {
+			out[pos++] = op_run | std::uint8_t(run - 1);
+			run = 0;
+		}
+
+		std::size_t idx = index_position(px);
+		if (index[idx] == px) {
+			out[pos++] = op_index | std::uint8_t(idx);
+			prev = px;
+			continue;
+		}
+		index[idx] = px;
+
+		if (px[3] != prev[3]) {
+			out[pos++] = op_rgba;
+			std::ranges::copy(px, out + pos);
+			pos += px.size();
+			prev = px;
+			continue;
+		}
+
+		auto vr = std::int8_t(px[0] - prev[0]);
+		auto vg = std::int8_t(px[1] - prev[1]);
+		auto vb = std::int8_t(px[2] - prev[2]);
+		int vg_r = vr - vg;
+		int vg_b = vb - vg;
+
+		if (vr > -3 && vr < 2 && vg > -3 && vg < 2 && vb > -3 && vb < 2) {
+			out[pos++] = op_diff | std::uint8_t((vr + 2) << 4 | (vg + 2) << 2 |
+			                                    (vb + 2));
+		} else if (vg_r > -9 && vg_r < 8 && vg > -33 && vg < 32 && vg_b > -9 &&
+		           vg_b < 8) {
+			out[pos++] = op_luma | std::uint8_t(vg + 32);
+			out[pos++] = std::uint8_t((vg_r + 8) << 4 | (vg_b + 8));
+		} else {
+			out[pos++] = op_rgb;
+			out[pos++] = px[0];
+			out[pos++] = px[1];
+			out[pos++] = px[2];
+		}
+
+		prev = px;
+	}
+
+	if (run > 0)
+		out[pos++] = op_run | std::uint8_t(run - 1);
+
+	std::ranges::copy(end_marker, out + pos);
+	pos += end_marker.size();
+
+	out_bytes.resize(pos);
+	return out_bytes;
+}
+} // namespace
+
+namespace ssimp::formats {
+/* static */ bool QOI::image_count_supported(std::size_t count) {
+	return count == 1;
+}
+
+/* static */ bool QOI::image_dims_supported(std::span<const std::size_t> dims) {
+	constexpr std::size_t max_dim = std::numeric_limits<std::uint32_t>::max();
+	return dims.size() == 2 && dims[0] > 0 && dims[1] > 0 &&
+	       dims[0] <= max_dim && dims[1] <= max_dim;
+}
+
+/* static */ std::optional<std::vector<img::LocalizedImage>>
+QOI::load_image(const std::filesystem::path& path,
+                const option_types::options_t& options) {
+	details::MappedFile file(path);
+	return decode(file.bytes());
+}
+
+/* static */ std::optional<std::vector<img::LocalizedImage>>
+QOI::load_image_from_memory(std::span<const std::byte> bytes,
+                            const option_types::options_t& options) {
+	return decode(bytes);
+}
+
+template <typename T>
+    requires mt::traits::is_any_of_tuple_v<T, QOI::supported_types>
+/* static */ void QOI::save_image(const std::vector<img::ndImage<T>>& imgs,
+                                  const std::filesystem::path& path,
+                                  const option_types::options_t& options) {
+	details::save_file(path, encode(imgs[0]));
+}
+
+template <typename T>
+    requires mt::traits::is_any_of_tuple_v<T, QOI::supported_types>
+/* static */ std::vector<std::byte>
+QOI::encode_image(const std::vector<img::ndImage<T>>& imgs,
+                  const option_types::options_t& options) {
+	return encode(imgs[0]);
+}
+
+/* static */ std::optional<ImageProperties>
+QOI::get_information(const std::filesystem::path& path,
+                     const option_types::options_t& options) {
+	details::MappedFile file(path);
+	std::optional<QoiHeader> header = read_header(file.bytes());
+	if (!header)
+		return {};
+
+	ImageProperties out{
+	    name, {std::size_t(header->width), std::size_t(header->height)}, {}};
+	out.others["Channels"] = std::to_string(header->channels);
+	out.others["Colorspace"] = header->colorspace == 0 ? "sRGB" : "Linear";
+	return out;
+}
+
+INSTANTIATE_SAVE_TEMPLATE(QOI, img::RGB_8);
+INSTANTIATE_SAVE_TEMPLATE(QOI, img::RGBA_8);
+
+} // namespace ssimp::formats
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "common.hpp"
+
+namespace ssimp::formats {
+/**
+ * "Quite OK Image" format, lossless with a single pass encoder and decoder,
+ * which are several times faster than PNG at similar size.
+ */
+class QOI {
+  public:
+	using supported_types = std::tuple<img::RGB_8, img::RGBA_8>;
+	constexpr static const char* name = "qoi";
+
+	static bool image_count_supported(std::size_t count);
+	static bool image_dims_supported(std::span<const std::size_t> dims);
+	static constexpr bool same_dims_required() { return true; }
+
+	static std::optional<std::vector<img::LocalizedImage>>
+	load_image(const std::filesystem::path& path,
+	           const option_types::options_t& options);
+
+	static std::optional<std::vector<img::LocalizedImage>>
+	load_image_from_memory(std::span<const std::byte> bytes,
+	                       const option_types::options_t& options);
+
+	template <typename T>
+	    requires mt::traits::is_any_of_tuple_v<T, QOI::supported_types>
+	static void save_image(const std::vector<img::ndImage<T>>& imgs,
+	                       const std::filesystem::path& path,
+	                       const option_types::options_t& options);
+
+	template <typename T>
+	    requires mt::traits::is_any_of_tuple_v<T, QOI::supported_types>
+	static std::vector<std::byte>
+	encode_image(const std::vector<img::ndImage<T>>& imgs,
+	             const option_types::options_t& options);
+
+	static std::optional<ImageProperties>
+	get_information(const std::filesystem::path& path,
+	                const option_types::options_t& options);
+};
+} // namespace ssimp::formats
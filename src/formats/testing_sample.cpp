@@ -8,6 +8,12 @@ TestingSample::load_image(const fs::path& path,
 	return std::vector<img::LocalizedImage>{};
 }
 
+/* static */ std::optional<std::vector<img::LocalizedImage>>
+TestingSample::load_image_from_memory(std::span<const std::byte> bytes,
+                                      const option_types::options_t&) {
+	return std::vector<img::LocalizedImage>{};
+}
+
 /* static */
 std::optional<ImageProperties>
 TestingSample::get_information(const fs::path& path,
@@ -38,6 +44,25 @@ TestingSample::save_image(const std::vector<img::ndImage<T>>& imgs,
 	}
 }
 
+template <typename T>
+    requires mt::traits::is_any_of_tuple_v<T, TestingSample::supported_types>
+/* static */ std::vector<std::byte>
+TestingSample::encode_image(const std::vector<img::ndImage<T>>& imgs,
+                            const option_types::options_t& options) {
+	std::ostringstream ss;
+	ss << std::format("Writing {} images to memory\n\n", imgs.size());
+
+	for (const auto& img : imgs) {
+		ss << img << '\n';
+	}
+
+	std::string str = ss.str();
+	std::vector<std::byte> out(str.size());
+	std::ranges::transform(str, out.begin(),
+	                       [](char ch) { return std::byte(ch); });
+	return out;
+}
+
 INSTANTIATE_SAVE_TEMPLATE(TestingSample, img::GRAY_8);
 
 } // namespace ssimp::formats
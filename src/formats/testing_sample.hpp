@@ -16,6 +16,10 @@ class TestingSample {
 	load_image(const std::filesystem::path&,
 	           const option_types::options_t& options);
 
+	static std::optional<std::vector<img::LocalizedImage>>
+	load_image_from_memory(std::span<const std::byte> bytes,
+	                       const option_types::options_t& options);
+
 	template <typename T>
 	    requires mt::traits::is_any_of_tuple_v<T,
 	                                           TestingSample::supported_types>
@@ -23,6 +27,13 @@ class TestingSample {
 	                       const std::filesystem::path& path,
 	                       const option_types::options_t& options);
 
+	template <typename T>
+	    requires mt::traits::is_any_of_tuple_v<T,
+	                                           TestingSample::supported_types>
+	static std::vector<std::byte>
+	encode_image(const std::vector<img::ndImage<T>>& imgs,
+	             const option_types::options_t& options);
+
 	static std::optional<ImageProperties>
 	get_information(const std::filesystem::path& path,
 	                const option_types::options_t& options);
@@ -0,0 +1,187 @@
+#include "../src/algorithms/blur.hpp"
+#include "common.hpp"
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+namespace {
+template <typename T>
+img::ndImage<T> blur(const img::ndImage<T>& img,
+                     const option_types::options_t& changes) {
+	option_types::options_t options{{"filter", "gaussian"s},
+	                                {"intensity", 1.5},
+	                                {"gaussian_method", "fir"s},
+	                                {"box_passes", int32_t(1)},
+	                                {"bound_condition", "nearest"s},
+	                                {"threads", int32_t(2)},
+	                                {"one_dim", false}};
+	for (const auto& [name, value] : changes)
+		options[name] = value;
+	return algorithms::Blur::apply<T>({img}, options)[0]
+	    .image.template as_typed<T>();
+}
+
+/**
+ * Blur **img** one dimension after another, slabs are never used.
+ */
+template <typename T>
+img::ndImage<T> blur_dims(img::ndImage<T> img,
+                          const option_types::options_t& changes) {
+	for (std::size_t dim = 0; dim < img.dims().size(); ++dim) {
+		option_types::options_t options = changes;
+		options["one_dim"] = true;
+		options["dim_idx"] = int32_t(dim);
+		img = blur(img, options);
+	}
+	return img;
+}
+
+std::vector<double> gaussian_kernel(double sigma) {
+	auto radius = std::ptrdiff_t(std::ceil(3 * sigma));
+	std::vector<double> out;
+	for (std::ptrdiff_t i = -radius; i <= radius; ++i)
+		out.push_back(std::exp(-double(i * i) / (2 * sigma * sigma)));
+
+	double sum = 0;
+	for (double weight : out)
+		sum += weight;
+	for (double& weight : out)
+		weight /= sum;
+	return out;
+}
+
+/**
+ * Box of odd **size** convolved with itself, so it is applied **passes**
+ * times.
+ */
+std::vector<double> box_kernel(std::size_t size, std::size_t passes) {
+	std::vector<double> box(size, 1.0 / double(size));
+	std::vector<double> out{1.0};
+	for (std::size_t pass = 0; pass < passes; ++pass) {
+		std::vector<double> next(out.size() + size - 1);
+		for (std::size_t i = 0; i < out.size(); ++i)
+			for (std::size_t k = 0; k < size; ++k)
+				next[i + k] += out[i] * box[k];
+		out = next;
+	}
+	return out;
+}
+
+/**
+ * Blur of 2D scalar **img** by **kernel** computed element by element. The
+ * result is stored to **T** after each dimension.
+ */
+template <typename T>
+img::ndImage<T> reference_blur(img::ndImage<T> img,
+                               const std::vector<double>& kernel,
+                               const std::string& bound) {
+	auto radius = std::ptrdiff_t(kernel.size() / 2);
+	for (std::size_t dim = 0; dim < 2; ++dim) {
+		auto length = std::ptrdiff_t(img.dims()[dim]);
+		auto stride = std::ptrdiff_t(dim == 0 ? 1 : img.dims()[0]);
+		img::ndImage<T> out(img.dims());
+
+		for (std::ptrdiff_t i = 0; i < std::ptrdiff_t(out.span().size());
+		     ++i) {
+			std::ptrdiff_t coord = i / stride % length;
+			double sum = 0;
+			for (std::ptrdiff_t k = -radius; k <= radius; ++k) {
+				std::ptrdiff_t from = source(coord + k, length, bound);
+				if (from >= 0)
+					sum += kernel[k + radius] *
+					       double(img.span()[i + (from - coord) * stride]);
+			}
+			out.span()[i] = T(sum);
+		}
+		img = std::move(out);
+	}
+	return img;
+}
+} // namespace
+
+TEST_CASE("Blur") {
+	const std::vector<std::string> bounds{"zero", "nearest", "mirror"};
+
+	SECTION("Gaussian kernel") {
+		for (const std::string& bound : bounds) {
+			auto img = pattern<img::DOUBLE>({23, 17});
+			option_types::options_t options{{"intensity", 2.0},
+			                                {"bound_condition", bound}};
+			REQUIRE(max_difference(
+			            blur(img, options),
+			            reference_blur(img, gaussian_kernel(2.0), bound)) <
+			        1e-9);
+		}
+	}
+
+	SECTION("8-bit fixed point kernel is within one of reference") {
+		for (const std::string& bound : bounds)
+			for (double sigma : {0.8, 1.5, 3.0}) {
+				auto img = pattern<img::GRAY_8>({41, 29});
+				option_types::options_t options{{"intensity", sigma},
+				                                {"bound_condition", bound}};
+				REQUIRE(max_difference(
+				            blur(img, options),
+				            reference_blur(img, gaussian_kernel(sigma),
+				                           bound)) <= 1);
+			}
+	}
+
+	SECTION("Box passes equal the repeated box kernel") {
+		for (const std::string& bound : bounds)
+			for (std::size_t passes : {1, 2, 3}) {
+				auto img = pattern<img::DOUBLE>({37, 31});
+				option_types::options_t options{
+				    {"filter", "box"s},
+				    {"intensity", 5.0},
+				    {"box_passes", int32_t(passes)},
+				    {"bound_condition", bound}};
+				REQUIRE(max_difference(
+				            blur(img, options),
+				            reference_blur(img, box_kernel(5, passes),
+				                           bound)) < 1e-9);
+			}
+	}
+
+	SECTION("Recursive gaussian approximates the kernel") {
+		// samples are random in [0, 255], the approximation is within one and
+		// a half level even for small sigma
+		for (const std::string& bound : bounds)
+			for (double sigma : {2.0, 6.0, 15.0}) {
+				auto img = pattern<img::DOUBLE>({120, 100});
+				option_types::options_t fir{{"intensity", sigma},
+				                            {"bound_condition", bound}};
+				option_types::options_t iir = fir;
+				iir["gaussian_method"] = "iir"s;
+				REQUIRE(max_difference(blur(img, fir), blur(img, iir)) < 1.5);
+			}
+	}
+
+	SECTION("Slabs equal blurring the whole image") {
+		// both images are split into more than one slab
+		auto gray = pattern<img::GRAY_8>({256, 256, 100});
+		auto floats = pattern<img::FLOAT>({64, 64, 300});
+
+		for (const std::string& bound : bounds)
+			for (const option_types::options_t& filter :
+			     {option_types::options_t{{"intensity", 1.5}},
+			      option_types::options_t{{"filter", "box"s},
+			                              {"intensity", 5.0},
+			                              {"box_passes", int32_t(2)}}}) {
+				option_types::options_t options = filter;
+				options["bound_condition"] = bound;
+
+				auto slabs = blur(gray, options);
+				REQUIRE(std::ranges::equal(slabs.span(),
+				                           blur_dims(gray, options).span()));
+				options["threads"] = int32_t(1);
+				REQUIRE(std::ranges::equal(slabs.span(),
+				                           blur(gray, options).span()));
+
+				options["threads"] = int32_t(2);
+				REQUIRE(std::ranges::equal(blur(floats, options).span(),
+				                           blur_dims(floats, options).span()));
+			}
+	}
+}
@@ -0,0 +1,48 @@
+#include "../src/application/api.hpp"
+#include "common.hpp"
+#include <algorithm>
+#include <vector>
+
+TEST_CASE("Chunked") {
+	API api;
+	option_types::options_t saving{{"chunk_size", int32_t(8)},
+	                               {"threads", int32_t(3)}};
+
+	SECTION("Round trip") {
+		auto img = pattern<img::FLOAT>({37, 20});
+		auto bytes = api.encode_image({img}, "chunked", saving);
+		auto loaded = api.load_image_from_memory(bytes, "chunked");
+
+		REQUIRE(loaded.size() == 1);
+		REQUIRE(loaded[0].image.dims() == img.dims());
+		REQUIRE(std::ranges::equal(
+		    loaded[0].image.as_typed<img::FLOAT>().span(), img.span()));
+	}
+
+	SECTION("Region across chunk borders") {
+		auto img = pattern<img::RGB_8>({21, 13, 6});
+		auto bytes = api.encode_image({img}, "chunked", saving);
+
+		std::vector<std::size_t> origin{5, 3, 2};
+		std::vector<std::size_t> size{14, 10, 4};
+		option_types::options_t loading{
+		    {"region", true},
+		    {"region_x", int32_t(origin[0])},
+		    {"region_y", int32_t(origin[1])},
+		    {"region_z", int32_t(origin[2])},
+		    {"region_width", int32_t(size[0])},
+		    {"region_height", int32_t(size[1])},
+		    {"region_depth", int32_t(size[2])}};
+		auto loaded = api.load_image_from_memory(bytes, "chunked", loading);
+
+		REQUIRE(loaded.size() == 1);
+		REQUIRE(loaded[0].image.dims() == size);
+		auto region = loaded[0].image.as_typed<img::RGB_8>();
+		for (int z = 0; z < int(size[2]); ++z)
+			for (int y = 0; y < int(size[1]); ++y)
+				for (int x = 0; x < int(size[0]); ++x)
+					REQUIRE(region(x, y, z) == img(x + int(origin[0]),
+					                               y + int(origin[1]),
+					                               z + int(origin[2])));
+	}
+}
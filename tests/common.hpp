@@ -1,7 +1,66 @@
 #pragma once
 
+#include "../src/application/nd_image.hpp"
 #include <catch2/catch_template_test_macros.hpp>
 #include <catch2/catch_test_macros.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <vector>
 
 using namespace std::literals;
 using namespace ssimp;
+
+/**
+ * Image of **dims** with pseudo-random samples in [0, 255], the same for
+ * every call.
+ */
+template <typename T>
+img::ndImage<T> pattern(const std::vector<std::size_t>& dims) {
+	img::ndImage<T> out(dims);
+	std::uint32_t state = 12345;
+	auto next = [&]() {
+		state = state * 1664525 + 1013904223;
+		return state >> 24;
+	};
+
+	for (T& elem : out) {
+		if constexpr (std::is_scalar_v<T>)
+			elem = T(next());
+		else
+			for (auto& sample : elem)
+				sample = typename T::value_type(next());
+	}
+	return out;
+}
+
+/**
+ * Largest difference between elements of scalar images **a** and **b**.
+ */
+template <typename T>
+double max_difference(const img::ndImage<T>& a, const img::ndImage<T>& b) {
+	double out = 0;
+	for (std::size_t i = 0; i < a.span().size(); ++i)
+		out = std::max(out,
+		               std::abs(double(a.span()[i]) - double(b.span()[i])));
+	return out;
+}
+
+/**
+ * Position read instead of **coord** outside of line of **length**, -1 means
+ * zero. Mirroring assumes the window is shorter than the line.
+ */
+inline std::ptrdiff_t source(std::ptrdiff_t coord,
+                             std::ptrdiff_t length,
+                             const std::string& bound) {
+	if (coord >= 0 && coord < length)
+		return coord;
+	if (bound == "zero")
+		return -1;
+	if (bound == "nearest")
+		return std::clamp(coord, std::ptrdiff_t(0), length - 1);
+	return coord < 0 ? -coord : 2 * length - coord - 1;
+}
@@ -0,0 +1,92 @@
+#include "../src/algorithms/convolve.hpp"
+#include "common.hpp"
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+namespace {
+template <typename T>
+img::ndImage<T> convolve(const std::vector<img::ndImage<T>>& imgs,
+                         const std::string& kernel,
+                         const std::string& method,
+                         const std::string& bound = "zero") {
+	option_types::options_t options{{"kernel", kernel},
+	                                {"normalize", false},
+	                                {"bound_condition", bound},
+	                                {"method", method},
+	                                {"threads", int32_t(2)}};
+	return algorithms::Convolve::apply(imgs, options)[0]
+	    .image.template as_typed<T>();
+}
+} // namespace
+
+TEST_CASE("Convolve") {
+	const std::vector<std::string> bounds{"zero", "nearest", "mirror"};
+
+	SECTION("Methods give equal results") {
+		for (const std::string& bound : bounds) {
+			auto img = pattern<img::DOUBLE>({23, 17});
+			std::string kernel = "1,2,1;2,4,2;1,2,1";
+			auto direct = convolve<img::DOUBLE>({img}, kernel, "direct", bound);
+
+			REQUIRE(max_difference(
+			            direct, convolve<img::DOUBLE>({img}, kernel,
+			                                          "separable", bound)) <
+			        1e-9);
+			REQUIRE(max_difference(direct, convolve<img::DOUBLE>(
+			                                   {img}, kernel, "fft", bound)) <
+			        1e-6);
+		}
+	}
+
+	SECTION("Integer results are equal") {
+		for (const std::string& bound : bounds) {
+			auto img = pattern<img::GRAY_8>({19, 13});
+			std::string kernel = "0.25,0.5,0.25;0.5,1,0.5;0.25,0.5,0.25";
+			auto direct = convolve<img::GRAY_8>({img}, kernel, "direct", bound);
+
+			for (std::string method : {"separable", "fft"}) {
+				auto out = convolve<img::GRAY_8>({img}, kernel, method, bound);
+				REQUIRE(std::ranges::equal(direct.span(), out.span()));
+			}
+		}
+	}
+
+	SECTION("Even sized kernel") {
+		img::ndImage<img::DOUBLE> img(std::vector<std::size_t>{4});
+		std::ranges::copy(std::vector<double>{1, 2, 3, 4}, img.begin());
+
+		// the element at index 1 is aligned with the output
+		for (std::string method : {"direct", "separable", "fft"}) {
+			auto out = convolve<img::DOUBLE>({img}, "1,2", method);
+			std::vector<double> expected{4, 7, 10, 8};
+			for (std::size_t i = 0; i < expected.size(); ++i)
+				REQUIRE(std::abs(out.span()[i] - expected[i]) < 1e-9);
+		}
+	}
+
+	SECTION("Kernel as the second image") {
+		auto img = pattern<img::DOUBLE>({15, 12});
+		img::ndImage<img::DOUBLE> kernel(std::vector<std::size_t>{3, 2});
+		std::ranges::copy(std::vector<double>{1, -2, 3, 0.5, 4, -1},
+		                  kernel.begin());
+
+		for (const std::string& bound : bounds)
+			REQUIRE(max_difference(
+			            convolve<img::DOUBLE>({img, kernel}, "1", "direct",
+			                                  bound),
+			            convolve<img::DOUBLE>({img}, "1,-2,3;0.5,4,-1",
+			                                  "direct", bound)) < 1e-9);
+	}
+
+	SECTION("Separable method falls back to direct") {
+		auto img = pattern<img::FLOAT>({16, 9});
+		std::string kernel = "0,1,0;1,1,1;0,1,0";
+
+		for (const std::string& bound : bounds)
+			REQUIRE(std::ranges::equal(
+			    convolve<img::FLOAT>({img}, kernel, "separable", bound).span(),
+			    convolve<img::FLOAT>({img}, kernel, "direct", bound).span()));
+	}
+}
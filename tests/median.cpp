@@ -0,0 +1,117 @@
+#include "../src/algorithms/median.hpp"
+#include "common.hpp"
+#include <algorithm>
+#include <array>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace {
+template <typename T>
+img::ndImage<T> median(const img::ndImage<T>& img,
+                       std::size_t radius,
+                       const std::string& bound) {
+	option_types::options_t options{{"radius", int32_t(radius)},
+	                                {"bound_condition", bound},
+	                                {"threads", int32_t(3)}};
+	return algorithms::Median::apply<T>({img}, options)[0]
+	    .image.template as_typed<T>();
+}
+
+template <typename T>
+struct samples {
+	using type = T;
+	static constexpr std::size_t count = 1;
+};
+
+template <typename S, std::size_t N>
+struct samples<std::array<S, N>> {
+	using type = S;
+	static constexpr std::size_t count = N;
+};
+
+/**
+ * Median computed by sorting every window.
+ */
+template <typename T>
+img::ndImage<T> sorted_median(const img::ndImage<T>& img,
+                              std::size_t radius,
+                              const std::string& bound) {
+	constexpr bool scalar = std::is_scalar_v<T>;
+	constexpr std::size_t channels = samples<T>::count;
+	using value_t = typename samples<T>::type;
+
+	auto width = std::ptrdiff_t(img.dims()[0]);
+	auto height = std::ptrdiff_t(img.dims()[1]);
+	auto r = std::ptrdiff_t(radius);
+	img::ndImage<T> out(img.dims());
+
+	for (std::ptrdiff_t y = 0; y < height; ++y)
+		for (std::ptrdiff_t x = 0; x < width; ++x)
+			for (std::size_t c = 0; c < channels; ++c) {
+				std::vector<value_t> values;
+				for (std::ptrdiff_t dy = -r; dy <= r; ++dy)
+					for (std::ptrdiff_t dx = -r; dx <= r; ++dx) {
+						std::ptrdiff_t sx = source(x + dx, width, bound);
+						std::ptrdiff_t sy = source(y + dy, height, bound);
+						value_t value = 0;
+						if (sx >= 0 && sy >= 0) {
+							const T& elem = img.span()[sy * width + sx];
+							if constexpr (scalar)
+								value = elem;
+							else
+								value = elem[c];
+						}
+						values.push_back(value);
+					}
+
+				std::ranges::sort(values);
+				T& elem = out.span()[y * width + x];
+				if constexpr (scalar)
+					elem = values[values.size() / 2];
+				else
+					elem[c] = values[values.size() / 2];
+			}
+	return out;
+}
+
+template <typename T>
+bool matches_sorted(std::size_t width,
+                    std::size_t height,
+                    std::size_t radius,
+                    const std::string& bound) {
+	auto img = pattern<T>({width, height});
+	return std::ranges::equal(median(img, radius, bound).span(),
+	                          sorted_median(img, radius, bound).span());
+}
+} // namespace
+
+TEST_CASE("Median") {
+	const std::vector<std::string> bounds{"zero", "nearest", "mirror"};
+
+	SECTION("Sorting networks") {
+		for (const std::string& bound : bounds)
+			for (std::size_t radius : {1, 2}) {
+				REQUIRE(matches_sorted<img::GRAY_8>(37, 23, radius, bound));
+				REQUIRE(matches_sorted<img::RGB_8>(19, 11, radius, bound));
+				REQUIRE(matches_sorted<img::GRAY_16>(70, 5, radius, bound));
+			}
+	}
+
+	SECTION("Column histograms") {
+		for (const std::string& bound : bounds)
+			for (std::size_t radius : {3, 4, 9}) {
+				REQUIRE(matches_sorted<img::GRAY_8>(41, 29, radius, bound));
+				REQUIRE(matches_sorted<img::RGBA_8>(23, 17, radius, bound));
+			}
+	}
+
+	SECTION("Other types") {
+		for (const std::string& bound : bounds)
+			for (std::size_t radius : {0, 1, 3, 5}) {
+				REQUIRE(matches_sorted<img::FLOAT>(17, 13, radius, bound));
+				REQUIRE(matches_sorted<img::DOUBLE>(9, 14, radius, bound));
+				REQUIRE(matches_sorted<img::GRAY_32>(12, 12, radius, bound));
+			}
+	}
+}
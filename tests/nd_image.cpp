@@ -74,4 +74,23 @@ TEMPLATE_LIST_TEST_CASE("ndImage", "ndImage[template]", scalar_type_list) {
 		REQUIRE(image(0, 2, 3) == T(23));
 		REQUIRE(image(1, 2, 3) == T(24));
 	}
+
+	SECTION("External storage") {
+		auto storage = std::make_shared<std::vector<T>>(24, T(1));
+		std::weak_ptr<std::vector<T>> weak = storage;
+		img::ndImage<T> external(image.dims(), storage, *storage);
+		storage.reset();
+
+		external(1, 2, 3) = T(4);
+		REQUIRE(!weak.expired());
+		REQUIRE((*weak.lock())[23] == T(4));
+		REQUIRE(external(0, 0, 0) == T(1));
+
+		img::ndImage<T> cpy = external.copy();
+		external(1, 2, 3) = T(5);
+		REQUIRE(cpy(1, 2, 3) == T(4));
+
+		external = image;
+		REQUIRE(weak.expired());
+	}
 }
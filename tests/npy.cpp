@@ -0,0 +1,179 @@
+#include "../src/application/api.hpp"
+#include "common.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+std::string_view as_text(std::span<const std::byte> bytes) {
+	return {reinterpret_cast<const char*>(bytes.data()), bytes.size()};
+}
+
+/**
+ * Version 1.0 .npy file with header **dict** followed by **samples**.
+ */
+std::vector<std::byte> file_bytes(std::string_view dict,
+                                  std::vector<std::uint8_t> samples) {
+	std::vector<std::byte> out;
+	for (char c : "\x93NUMPY\x01\x00"sv)
+		out.push_back(std::byte(c));
+	std::size_t length = dict.size() + 1;
+	out.push_back(std::byte(length & 0xff));
+	out.push_back(std::byte(length >> 8));
+	for (char c : dict)
+		out.push_back(std::byte(c));
+	out.push_back(std::byte('\n'));
+	for (std::uint8_t sample : samples)
+		out.push_back(std::byte(sample));
+	return out;
+}
+
+template <typename T>
+img::ndImage<T> round_trip(const API& api, const img::ndImage<T>& img) {
+	auto loaded =
+	    api.load_image_from_memory(api.encode_image({img}, "npy"), "npy");
+	REQUIRE(loaded.size() == 1);
+	REQUIRE(loaded[0].image.type() == img::type_to_enum<T>);
+	REQUIRE(loaded[0].image.dims() == img.dims());
+	return loaded[0].image.template as_typed<T>();
+}
+} // namespace
+
+TEST_CASE("NPY") {
+	API api;
+
+	SECTION("Round trip") {
+		auto gray = pattern<img::GRAY_8>({13, 7});
+		REQUIRE(std::ranges::equal(round_trip(api, gray).span(), gray.span()));
+
+		auto gray_16 = pattern<img::GRAY_16>({5, 9, 2});
+		REQUIRE(std::ranges::equal(round_trip(api, gray_16).span(),
+		                           gray_16.span()));
+
+		auto floats = pattern<img::FLOAT>({17});
+		REQUIRE(std::ranges::equal(round_trip(api, floats).span(),
+		                           floats.span()));
+
+		auto doubles = pattern<img::DOUBLE>({4, 3, 2, 2});
+		REQUIRE(std::ranges::equal(round_trip(api, doubles).span(),
+		                           doubles.span()));
+	}
+
+	SECTION("Channels are fields of structured arrays") {
+		auto graya = pattern<img::GRAYA_8>({3, 8});
+		auto bytes = api.encode_image({graya}, "npy");
+		REQUIRE(as_text(bytes).contains(
+		    "'descr': [('y', '|u1'), ('a', '|u1')]"));
+		REQUIRE(std::ranges::equal(round_trip(api, graya).span(),
+		                           graya.span()));
+
+		auto rgb = pattern<img::RGB_8>({11, 4});
+		bytes = api.encode_image({rgb}, "npy");
+		REQUIRE(as_text(bytes).contains(
+		    "'descr': [('r', '|u1'), ('g', '|u1'), ('b', '|u1')]"));
+		REQUIRE(std::ranges::equal(round_trip(api, rgb).span(), rgb.span()));
+
+		auto rgba = pattern<img::RGBA_8>({6, 6});
+		REQUIRE(std::ranges::equal(round_trip(api, rgba).span(),
+		                           rgba.span()));
+
+		// field names do not matter
+		auto loaded = api.load_image_from_memory(
+		    file_bytes("{'descr': [('l', 'u1'), ('x', '|u1')], "
+		               "'fortran_order': False, 'shape': (1, 2), }",
+		               {1, 2, 3, 4}),
+		    "npy");
+		REQUIRE(loaded[0].image.type() == img::elem_type::GRAYA_8);
+		auto elems = loaded[0].image.as_typed<img::GRAYA_8>().span();
+		REQUIRE(elems[0] == img::GRAYA_8{1, 2});
+		REQUIRE(elems[1] == img::GRAYA_8{3, 4});
+	}
+
+	SECTION("Big endian samples are swapped") {
+		auto loaded = api.load_image_from_memory(
+		    file_bytes("{'descr': '>u2', 'fortran_order': False, "
+		               "'shape': (2,), }",
+		               {0x12, 0x34, 0xAB, 0xCD}),
+		    "npy");
+		auto samples = loaded[0].image.as_typed<img::GRAY_16>().span();
+		REQUIRE(samples[0] == 0x1234);
+		REQUIRE(samples[1] == 0xABCD);
+
+		loaded = api.load_image_from_memory(
+		    file_bytes("{'descr': '>f4', 'fortran_order': False, "
+		               "'shape': (1,), }",
+		               {0x3F, 0xC0, 0x00, 0x00}),
+		    "npy");
+		REQUIRE(loaded[0].image.as_typed<img::FLOAT>().span()[0] == 1.5f);
+	}
+
+	SECTION("Fortran order") {
+		std::vector<std::uint8_t> samples{0, 1, 2, 3, 4, 5};
+		auto c_order = api.load_image_from_memory(
+		    file_bytes("{'descr': '|u1', 'fortran_order': False, "
+		               "'shape': (2, 3), }",
+		               samples),
+		    "npy")[0];
+		auto fortran = api.load_image_from_memory(
+		    file_bytes("{'descr': '|u1', 'fortran_order': True, "
+		               "'shape': (2, 3), }",
+		               samples),
+		    "npy")[0];
+
+		// the first axis changes the fastest
+		REQUIRE(c_order.image.dims() == std::vector<std::size_t>{3, 2});
+		REQUIRE(fortran.image.dims() == std::vector<std::size_t>{2, 3});
+		auto img = fortran.image.as_typed<img::GRAY_8>();
+		REQUIRE(img(1, 0) == 1);
+		REQUIRE(img(0, 2) == 4);
+	}
+
+	SECTION("Last axis as channels") {
+		auto bytes = file_bytes("{'descr': '|u1', 'fortran_order': False, "
+		                        "'shape': (2, 1, 3), }",
+		                        {1, 2, 3, 4, 5, 6});
+
+		auto plain = api.load_image_from_memory(bytes, "npy")[0];
+		REQUIRE(plain.image.type() == img::elem_type::GRAY_8);
+		REQUIRE(plain.image.dims() == std::vector<std::size_t>{3, 1, 2});
+
+		auto channels =
+		    api.load_image_from_memory(bytes, "npy", {{"channels", true}})[0];
+		REQUIRE(channels.image.type() == img::elem_type::RGB_8);
+		REQUIRE(channels.image.dims() == std::vector<std::size_t>{1, 2});
+		auto rgb = channels.image.as_typed<img::RGB_8>().span();
+		REQUIRE(rgb[1] == img::RGB_8{4, 5, 6});
+
+		// only byte arrays have channels
+		auto floats = api.load_image_from_memory(
+		    file_bytes("{'descr': '<f4', 'fortran_order': False, "
+		               "'shape': (1, 3), }",
+		               std::vector<std::uint8_t>(12)),
+		    "npy", {{"channels", true}})[0];
+		REQUIRE(floats.image.type() == img::elem_type::FLOAT);
+	}
+
+	SECTION("Loaded file refers to the mapping") {
+		auto img = pattern<img::FLOAT>({40, 30});
+		fs::path path = fs::temp_directory_path() / "ssimp_npy_mapped.npy";
+		api.save_image({img}, path, "npy");
+		std::size_t header_size = fs::file_size(path) - 40 * 30 * 4;
+
+		// the data follow the header in a page aligned mapping
+		auto loaded = api.load_one(path, "", "npy").image;
+		auto samples = loaded.as_typed<img::FLOAT>().span();
+		REQUIRE(std::uintptr_t(samples.data()) % 4096 == header_size);
+		REQUIRE(std::ranges::equal(samples, img.span()));
+
+		// the mapping is copy-on-write, the file stays unchanged
+		std::ranges::fill(samples, 0.0f);
+		auto reloaded = api.load_one(path, "", "npy").image;
+		REQUIRE(std::ranges::equal(reloaded.as_typed<img::FLOAT>().span(),
+		                           img.span()));
+		fs::remove(path);
+	}
+}
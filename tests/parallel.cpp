@@ -0,0 +1,50 @@
+#include "../src/application/parallel.hpp"
+#include "common.hpp"
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+TEST_CASE("Parallel for") {
+	SECTION("Every index is visited once") {
+		for (std::size_t threads : {0, 1, 2, 7}) {
+			std::vector<std::atomic<int>> visits(1000);
+			parallel::parallel_for(
+			    visits.size(), [&](std::size_t i) { ++visits[i]; }, threads);
+
+			REQUIRE(std::ranges::all_of(visits,
+			                            [](const auto& x) { return x == 1; }));
+		}
+	}
+
+	SECTION("Empty range") {
+		bool called = false;
+		parallel::parallel_for(0, [&](std::size_t) { called = true; });
+		REQUIRE(!called);
+	}
+
+	SECTION("Nested calls") {
+		std::vector<std::atomic<int>> visits(64 * 64);
+		parallel::parallel_for(
+		    64,
+		    [&](std::size_t i) {
+			    parallel::parallel_for(
+			        64, [&](std::size_t j) { ++visits[i * 64 + j]; }, 3);
+		    },
+		    5);
+
+		REQUIRE(std::ranges::all_of(visits,
+		                            [](const auto& x) { return x == 1; }));
+	}
+
+	SECTION("Exception is propagated") {
+		REQUIRE_THROWS_AS(parallel::parallel_for(
+		                      100,
+		                      [](std::size_t i) {
+			                      if (i == 42)
+				                      throw std::runtime_error("fail");
+		                      },
+		                      4),
+		                  std::runtime_error);
+	}
+}
@@ -0,0 +1,113 @@
+#include "../src/application/api.hpp"
+#include "common.hpp"
+#include <algorithm>
+#include <string_view>
+#include <vector>
+
+namespace {
+std::string_view as_text(std::span<const std::byte> bytes) {
+	return {reinterpret_cast<const char*>(bytes.data()), bytes.size()};
+}
+
+std::vector<std::byte> file_bytes(std::string_view header,
+                                  std::vector<std::uint8_t> samples) {
+	std::vector<std::byte> out;
+	for (char c : header)
+		out.push_back(std::byte(c));
+	for (std::uint8_t sample : samples)
+		out.push_back(std::byte(sample));
+	return out;
+}
+
+/**
+ * Encode **img** as PNM, check the magic number and load it back.
+ */
+template <typename T>
+img::ndImage<T> round_trip(const API& api,
+                           const img::ndImage<T>& img,
+                           std::string_view magic) {
+	auto bytes = api.encode_image({img}, "pnm");
+	REQUIRE(as_text(bytes).starts_with(magic));
+
+	auto loaded = api.load_image_from_memory(bytes, "pnm");
+	REQUIRE(loaded.size() == 1);
+	REQUIRE(loaded[0].image.type() == img::type_to_enum<T>);
+	return loaded[0].image.template as_typed<T>();
+}
+} // namespace
+
+TEST_CASE("PNM") {
+	API api;
+
+	SECTION("Round trip") {
+		auto gray = pattern<img::GRAY_8>({13, 7});
+		REQUIRE(std::ranges::equal(round_trip(api, gray, "P5").span(),
+		                           gray.span()));
+
+		auto gray_16 = pattern<img::GRAY_16>({5, 9});
+		REQUIRE(std::ranges::equal(round_trip(api, gray_16, "P5").span(),
+		                           gray_16.span()));
+
+		auto rgb = pattern<img::RGB_8>({11, 4});
+		REQUIRE(std::ranges::equal(round_trip(api, rgb, "P6").span(),
+		                           rgb.span()));
+
+		auto graya = pattern<img::GRAYA_8>({3, 8});
+		REQUIRE(std::ranges::equal(round_trip(api, graya, "P7").span(),
+		                           graya.span()));
+
+		auto rgba = pattern<img::RGBA_8>({6, 6});
+		REQUIRE(std::ranges::equal(round_trip(api, rgba, "P7").span(),
+		                           rgba.span()));
+	}
+
+	SECTION("16-bit samples are big endian") {
+		img::ndImage<img::GRAY_16> img(std::array<std::size_t, 2>{2, 1});
+		img.span()[0] = 0x1234;
+		img.span()[1] = 0xABCD;
+
+		auto bytes = api.encode_image({img}, "pnm");
+		std::string_view header = "P5\n2 1\n65535\n";
+		REQUIRE(bytes == file_bytes(header, {0x12, 0x34, 0xAB, 0xCD}));
+
+		auto loaded = api.load_image_from_memory(
+		    file_bytes(header, {0xAB, 0xCD, 0x00, 0x01}), "pnm");
+		auto samples = loaded[0].image.as_typed<img::GRAY_16>().span();
+		REQUIRE(samples[0] == 0xABCD);
+		REQUIRE(samples[1] == 0x0001);
+	}
+
+	SECTION("Samples are scaled to the full range") {
+		auto loaded = api.load_image_from_memory(
+		    file_bytes("P5\n3 1\n15\n", {0, 7, 15}), "pnm");
+		REQUIRE(loaded[0].image.type() == img::elem_type::GRAY_8);
+		auto gray = loaded[0].image.as_typed<img::GRAY_8>().span();
+		REQUIRE(gray[0] == 0);
+		REQUIRE(gray[1] == 119);
+		REQUIRE(gray[2] == 255);
+
+		loaded = api.load_image_from_memory(
+		    file_bytes("P6\n1 1\n100\n", {0, 50, 100}), "pnm");
+		auto rgb = loaded[0].image.as_typed<img::RGB_8>().span();
+		REQUIRE(rgb[0] == img::RGB_8{0, 128, 255});
+
+		loaded = api.load_image_from_memory(
+		    file_bytes("P5\n2 1\n1000\n", {0x01, 0xF4, 0x03, 0xE8}), "pnm");
+		REQUIRE(loaded[0].image.type() == img::elem_type::GRAY_16);
+		auto gray_16 = loaded[0].image.as_typed<img::GRAY_16>().span();
+		REQUIRE(gray_16[0] == 32768);
+		REQUIRE(gray_16[1] == 65535);
+	}
+
+	SECTION("Oversized or truncated images are rejected") {
+		// sizes of the first two wrap around to zero
+		for (std::string_view header :
+		     {"P7\nWIDTH 9223372036854775808\nHEIGHT 1\nDEPTH 2\nMAXVAL 255\n"
+		      "ENDHDR\n",
+		      "P5\n4294967296 4294967296\n255\n", "P6\n4 4\n255\n",
+		      "P5\n4 4\n"})
+			REQUIRE_THROWS_AS(api.load_image_from_memory(
+			                      file_bytes(header, {1, 2, 3, 4}), "pnm"),
+			                  exceptions::Unsupported);
+	}
+}
@@ -0,0 +1,121 @@
+#include "../src/application/api.hpp"
+#include "common.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace {
+/**
+ * QOI file of 4 channels with **chunks** between the header and the end
+ * marker.
+ */
+std::vector<std::byte> file_bytes(std::uint32_t width,
+                                  std::uint32_t height,
+                                  std::vector<std::uint8_t> chunks) {
+	std::vector<std::uint8_t> bytes{'q', 'o', 'i', 'f'};
+	for (std::uint32_t value : {width, height})
+		for (int shift = 24; shift >= 0; shift -= 8)
+			bytes.push_back(std::uint8_t(value >> shift));
+	bytes.push_back(4);
+	bytes.push_back(0);
+	bytes.insert(bytes.end(), chunks.begin(), chunks.end());
+	bytes.insert(bytes.end(), {0, 0, 0, 0, 0, 0, 0, 1});
+
+	std::vector<std::byte> out(bytes.size());
+	std::ranges::transform(bytes, out.begin(),
+	                       [](std::uint8_t x) { return std::byte(x); });
+	return out;
+}
+
+/**
+ * Image encoded by every kind of chunk: runs (the first row is longer than
+ * the longest run), differences small enough for DIFF and LUMA chunks,
+ * repeated colors for INDEX chunks and random colors for RGB(A) chunks.
+ */
+template <typename T>
+img::ndImage<T> chunk_image() {
+	auto out = pattern<T>({100, 20});
+	auto elems = out.span();
+	std::ranges::fill(elems.first(100), elems[0]);
+
+	for (std::size_t i = 100; i < elems.size(); ++i) {
+		T next = elems[i - 1];
+		switch (i / 7 % 5) {
+		case 0: // random
+			next = elems[i];
+			break;
+		case 1: // run
+			break;
+		case 2: // diff
+			for (std::size_t c = 0; c < 3; ++c)
+				next[c] = std::uint8_t(next[c] + i % 3 - 1);
+			break;
+		case 3: // luma
+			for (std::size_t c = 0; c < 3; ++c)
+				next[c] = std::uint8_t(next[c] + 20 + c);
+			break;
+		case 4: // index
+			next = elems[i - 14];
+			break;
+		}
+		elems[i] = next;
+	}
+	return out;
+}
+
+template <typename T>
+void require_round_trip(const API& api, const img::ndImage<T>& img) {
+	auto loaded =
+	    api.load_image_from_memory(api.encode_image({img}, "qoi"), "qoi");
+	REQUIRE(loaded.size() == 1);
+	REQUIRE(loaded[0].image.type() == img::type_to_enum<T>);
+	REQUIRE(loaded[0].image.dims() == img.dims());
+	REQUIRE(std::ranges::equal(
+	    loaded[0].image.template as_typed<T>().span(), img.span()));
+}
+} // namespace
+
+TEST_CASE("QOI") {
+	API api;
+
+	SECTION("Round trip") {
+		require_round_trip(api, chunk_image<img::RGB_8>());
+		require_round_trip(api, chunk_image<img::RGBA_8>());
+		require_round_trip(api, pattern<img::RGBA_8>({13, 7}));
+	}
+
+	SECTION("Chunks of the specification") {
+		// RGB, RUN of 2, DIFF, LUMA, INDEX, RGBA
+		auto bytes = file_bytes(7, 1,
+		                        {0xfe, 10, 20, 30, 0xc1, 0x76, 0xaa, 0xb6,
+		                         0x09, 0xff, 10, 20, 30, 128});
+		std::vector<img::RGBA_8> expected{
+		    {10, 20, 30, 255}, {10, 20, 30, 255}, {10, 20, 30, 255},
+		    {11, 19, 30, 255}, {24, 29, 38, 255}, {10, 20, 30, 255},
+		    {10, 20, 30, 128}};
+
+		auto loaded = api.load_image_from_memory(bytes, "qoi");
+		auto img = loaded[0].image.as_typed<img::RGBA_8>();
+		REQUIRE(img.dims() == std::vector<std::size_t>{7, 1});
+		REQUIRE(std::ranges::equal(img.span(), expected));
+
+		// the encoder picks the same chunks
+		REQUIRE(api.encode_image({img}, "qoi") == bytes);
+	}
+
+	SECTION("Sizes not covered by the data are rejected") {
+		// a chunk byte encodes at most 62 pixels
+		REQUIRE_THROWS_AS(api.load_image_from_memory(
+		                      file_bytes(0x10000, 0x10000, {0xfd}), "qoi"),
+		                  exceptions::Unsupported);
+		REQUIRE_THROWS_AS(
+		    api.load_image_from_memory(
+		        file_bytes(0xffffffff, 0xffffffff, {0xfd}), "qoi"),
+		    exceptions::Unsupported);
+
+		// truncated chunk
+		REQUIRE_THROWS_AS(
+		    api.load_image_from_memory(file_bytes(2, 1, {0xfe, 10}), "qoi"),
+		    exceptions::Unsupported);
+	}
+}
@@ -0,0 +1,55 @@
+#include "../src/application/api.hpp"
+#include "common.hpp"
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+
+namespace fs = std::filesystem;
+
+TEST_CASE("Transform") {
+	API api;
+
+	SECTION("Lossless JPEG transform matches decoded transform") {
+		// whole MCUs, so every operation is perfect
+		img::ndImage<img::GRAY_8> img(std::array<std::size_t, 2>{64, 48});
+		for (std::size_t y = 0; y < 48; ++y)
+			for (std::size_t x = 0; x < 64; ++x)
+				img.span()[y * 64 + x] = std::uint8_t(x * 3 + y * 2);
+
+		fs::path input = fs::temp_directory_path() / "ssimp_transform_in.jpg";
+		fs::path output = fs::temp_directory_path() / "ssimp_transform_out.jpg";
+		api.save_image({img}, input, "jpeg", {{"quality", int32_t(95)}});
+		auto decoded = api.load_one(input).image;
+
+		for (std::string operation :
+		     {"rotate_90", "rotate_180", "rotate_270", "flip_horizontal",
+		      "flip_vertical", "transpose", "transverse"}) {
+			option_types::options_t options{{"operation", operation}};
+			REQUIRE(api.transform_lossless(input, output, "jpeg", {options}));
+
+			auto lossless = api.load_one(output).image;
+			auto expected = api.apply({decoded}, "transform", options)[0].image;
+			REQUIRE(lossless.dims() == expected.dims());
+
+			// only rounding of the inverse DCT differs
+			auto a = lossless.as_typed<img::GRAY_8>().span();
+			auto b = expected.as_typed<img::GRAY_8>().span();
+			for (std::size_t i = 0; i < a.size(); ++i)
+				REQUIRE(std::abs(int(a[i]) - int(b[i])) <= 2);
+		}
+
+		fs::remove(input);
+		fs::remove(output);
+	}
+
+	SECTION("Lossless transform needs the same format") {
+		img::ndImage<img::GRAY_8> img(std::array<std::size_t, 2>{16, 16});
+		fs::path input = fs::temp_directory_path() / "ssimp_transform_in.pnm";
+		api.save_image({img}, input, "pnm");
+
+		REQUIRE(!api.transform_lossless(
+		    input, fs::temp_directory_path() / "ssimp_transform_out.jpg",
+		    "jpeg", {{{"operation", "rotate_90"s}}}));
+		fs::remove(input);
+	}
+}